@@ -8,7 +8,8 @@ case "$1" in
 
     'setup_qt')
         sudo apt-get update -qq
-        sudo apt-get -y install qt5-qmake qtbase5-dev libqt5sql5-sqlite zlib1g-dev
+        sudo apt-get -y install qt5-qmake qtbase5-dev libqt5sql5-sqlite zlib1g-dev \
+            libqt5x11extras5-dev libxcb1-dev
     ;;
 
     'get_quazip')
@@ -21,13 +22,14 @@ case "$1" in
         ./build-scripts/revision.sh
         qmake -qt=qt5 CONFIG+=linux_quazip_static
         make
+        (cd src/plugins/input-script && qmake -qt=qt5 && make)
     ;;
 
     'package')
         mkdir -p "build/$TRAVIS_BRANCH"
 
         mv resources/README.txt .
-        tar -cvzpf "build/$TRAVIS_BRANCH/mupen64plus-qt_linux_$VERSION.tar.gz" mupen64plus-qt README.txt
+        tar -cvzpf "build/$TRAVIS_BRANCH/mupen64plus-qt_linux_$VERSION.tar.gz" mupen64plus-qt mupen64plus-input-script.so README.txt
     ;;
 
 esac
@@ -36,6 +36,8 @@ case "$1" in
         ./build-scripts/revision.sh
         $WORKING_DIR/../osx/qtbase/bin/qmake -config release LIBS+="-dead_strip"
         make
+        (cd src/plugins/input-script && $WORKING_DIR/../osx/qtbase/bin/qmake -config release && make)
+        cp mupen64plus-input-script.so Mupen64Plus-Qt.app/Contents/MacOS/
     ;;
 
     'package')
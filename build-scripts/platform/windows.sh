@@ -42,13 +42,19 @@ case "$1" in
         ./build-scripts/revision.sh
         i686-w64-mingw32.static-qmake-qt5
         make
+        (cd src/plugins/input-script && i686-w64-mingw32.static-qmake-qt5 && make)
     ;;
 
     'package')
         mkdir -p "build/$TRAVIS_BRANCH"
 
+        if [[ ! -f mupen64plus-input-script.dll ]]; then
+            echo "mupen64plus-input-script.dll was not built" >&2
+            exit 1
+        fi
+
         mv release/mupen64plus-qt.exe resources/README.txt .
-        zip "build/$TRAVIS_BRANCH/mupen64plus-qt_win_$VERSION.zip" mupen64plus-qt.exe README.txt
+        zip "build/$TRAVIS_BRANCH/mupen64plus-qt_win_$VERSION.zip" mupen64plus-qt.exe mupen64plus-input-script.dll README.txt
     ;;
 
 esac
@@ -19,11 +19,13 @@ win32:RC_FILE = dist/windows/icon.rc
 
 SOURCES += src/main.cpp \
     src/cheatparse.cpp \
+    src/cheatprofile.cpp \
     src/common.cpp \
     src/core.cpp \
     src/mainwindow.cpp \
     src/error.cpp \
     src/plugin.cpp \
+    src/prefetch.cpp \
     src/sdl.cpp \
     src/settings.cpp \
     src/config/configcontrolcollection.cpp \
@@ -36,14 +38,22 @@ SOURCES += src/main.cpp \
     src/dialogs/gamesettingsdialog.cpp \
     src/dialogs/inputdialog.cpp \
     src/dialogs/logdialog.cpp \
+    src/dialogs/netplaydialog.cpp \
     src/dialogs/pluginconfigdialog.cpp \
     src/dialogs/settingsdialog.cpp \
     src/emulation/emulation.cpp \
     src/emulation/emuthread.cpp \
+    src/emulation/frametelemetry.cpp \
     src/emulation/glwindow.cpp \
+    src/emulation/inputscript.cpp \
+    src/emulation/netplay.cpp \
+    src/emulation/netplayserver.cpp \
+    src/emulation/sessionmemory.cpp \
     src/emulation/vidext.cpp \
     src/osal/osal_dynamiclib.c \
+    src/roms/blobstore.cpp \
     src/roms/romcollection.cpp \
+    src/roms/scanstats.cpp \
     src/roms/thegamesdbscraper.cpp \
     src/views/gridview.cpp \
     src/views/listview.cpp \
@@ -53,11 +63,13 @@ SOURCES += src/main.cpp \
 
 HEADERS += src/global.h \
     src/cheatparse.h \
+    src/cheatprofile.h \
     src/common.h \
     src/core.h \
     src/mainwindow.h \
     src/error.h \
     src/plugin.h \
+    src/prefetch.h \
     src/sdl.h \
     src/settings.h \
     src/config/configcontrolcollection.h \
@@ -70,14 +82,22 @@ HEADERS += src/global.h \
     src/dialogs/gamesettingsdialog.h \
     src/dialogs/inputdialog.h \
     src/dialogs/logdialog.h \
+    src/dialogs/netplaydialog.h \
     src/dialogs/pluginconfigdialog.h \
     src/dialogs/settingsdialog.h \
     src/emulation/emulation.h \
     src/emulation/emuthread.h \
+    src/emulation/frametelemetry.h \
     src/emulation/glwindow.h \
+    src/emulation/inputscript.h \
+    src/emulation/netplay.h \
+    src/emulation/netplayserver.h \
+    src/emulation/sessionmemory.h \
     src/emulation/vidext.h \
     src/osal/osal_dynamiclib.h \
+    src/roms/blobstore.h \
     src/roms/romcollection.h \
+    src/roms/scanstats.h \
     src/roms/thegamesdbscraper.h \
     src/views/gridview.h \
     src/views/listview.h \
@@ -119,6 +139,12 @@ win32|macx|linux_quazip_static {
     }
 }
 
+# Used to let fullscreen games bypass the compositor on X11
+linux {
+    QT   += x11extras
+    LIBS += -lxcb
+}
+
 INCLUDEPATH += /usr/include/SDL2
 LIBS += -lSDL2
 
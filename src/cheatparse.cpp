@@ -252,7 +252,7 @@ bool findNextCheatCode(Str &haystack) {
 
 
 static Cheat &addCheat(Cheat &rootCheat, Str fullName,
-                       const std::set<QString> &activeCheats)
+                       const CheatProfile &activeCheats)
 {
     Cheat *parent = &rootCheat;
     Str namePart = fullName.until('\\');
@@ -281,7 +281,7 @@ static Cheat &addCheat(Cheat &rootCheat, Str fullName,
 
 
 bool parseCheats(const char *codePtr, size_t codeSize, const char *section,
-                 const std::set<QString> &activeCheats, Cheat &rootCheat)
+                 const CheatProfile &activeCheats, Cheat &rootCheat)
 {
     Str code {codePtr, codeSize};
 
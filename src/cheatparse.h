@@ -32,7 +32,6 @@
 #ifndef CHEATPARSE_H
 #define CHEATPARSE_H
 
-#include <set>
 #include <map>
 #include <vector>
 #include <QString>
@@ -43,6 +42,9 @@ class QString;
 
 using CheatCode = m64p_cheat_code;
 
+// Enabled cheats by full name, with the codes they were enabled with.
+using CheatProfile = std::map<QString, std::vector<CheatCode>>;
+
 struct Cheat
 {
     Cheat(QString name, QString fullName, QString description,
@@ -65,6 +67,6 @@ struct Cheat
 
 
 bool parseCheats(const char *code, size_t codeSize, const char *section,
-                 const std::set<QString> &activeCheats, Cheat &rootCheat);
+                 const CheatProfile &activeCheats, Cheat &rootCheat);
 
 #endif // CHEATPARSE_H
@@ -0,0 +1,161 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#include "cheatprofile.h"
+#include "core.h"
+#include "error.h"
+#include "common.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <utility>
+
+#define FROM "cheats"
+
+#define PROFILE_MAGIC   0x4d363443
+#define PROFILE_VERSION 1
+
+
+static QString profileFileName(const QString &md5)
+{
+    return getDataLocation() + "/cheats/" + md5.toLower() + ".bin";
+}
+
+
+static bool loadCheatProfile(const QString &md5, CheatProfile &cheats)
+{
+    QFile file(profileFileName(md5));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic, count;
+    quint16 version;
+    in >> magic >> version >> count;
+    if (magic != PROFILE_MAGIC || version != PROFILE_VERSION) {
+        LOG(L_WARN, FROM, TR("Ignoring cheat profile of unknown format: ") + file.fileName());
+        return false;
+    }
+
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        QByteArray name;
+        quint32 codeCount;
+        in >> name >> codeCount;
+
+        std::vector<CheatCode> codes;
+        for (quint32 j = 0; j < codeCount && in.status() == QDataStream::Ok; j++) {
+            quint32 address;
+            qint32 value;
+            in >> address >> value;
+            codes.push_back({address, value});
+        }
+        cheats[QString::fromUtf8(name)] = std::move(codes);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        LOG(L_WARN, FROM, TR("Ignoring damaged cheat profile: ") + file.fileName());
+        cheats.clear();
+        return false;
+    }
+    return true;
+}
+
+
+void applyCheatProfile(const QString &md5, CheatProfile &cheats)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!loadCheatProfile(md5, cheats) || cheats.empty()) {
+        return;
+    }
+
+    int added = 0, codeCount = 0;
+    for (auto &cheat : cheats) {
+        std::vector<CheatCode> &codes = cheat.second;
+        if (codes.empty()) {
+            continue;
+        }
+        m64p_error rval;
+        rval = CoreAddCheat(cheat.first.toUtf8().data(), codes.data(), codes.size());
+        if (rval != M64ERR_SUCCESS) {
+            LOG(L_WARN, FROM, TR("Could not enable cheat <Name>: ")
+                    .replace("<Name>", cheat.first) + m64errstr(rval));
+            continue;
+        }
+        added++;
+        codeCount += codes.size();
+    }
+
+    LOG(L_INFO, FROM, TR("Enabled <N> cheats with <Codes> codes in <Time> ms.")
+            .replace("<N>", QString::number(added))
+            .replace("<Codes>", QString::number(codeCount))
+            .replace("<Time>", QString::number(timer.nsecsElapsed() / 1e6, 'f', 2)));
+}
+
+
+bool saveCheatProfile(const QString &md5, const CheatProfile &cheats)
+{
+    if (md5.isEmpty()) {
+        return false;
+    }
+
+    QString fileName = profileFileName(md5);
+    if (cheats.empty()) {
+        QFile::remove(fileName);
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(fileName).path());
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG(L_WARN, FROM, TR("Could not save cheat profile: ") + fileName);
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << quint32(PROFILE_MAGIC) << quint16(PROFILE_VERSION)
+        << quint32(cheats.size());
+    for (const auto &cheat : cheats) {
+        out << cheat.first.toUtf8() << quint32(cheat.second.size());
+        for (const CheatCode &code : cheat.second) {
+            out << quint32(code.address) << qint32(code.value);
+        }
+    }
+
+    return file.commit();
+}
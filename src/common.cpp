@@ -60,6 +60,18 @@
 
 #include <assert.h>
 
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
 
 void setTheme()
 {
@@ -496,3 +508,76 @@ const char *mapFile(QFile &file)
     file.close();
     return (const char *)romData;
 }
+
+
+#ifdef Q_OS_LINUX
+// Returns the extent list of the file if every extent is shared with some
+// other file, otherwise an empty string. Two files with the same size and
+// the same shared extents have the same contents.
+static QString getSharedExtentsKey(int fd)
+{
+    const int maxExtents = 64;
+    QByteArray buffer(sizeof(struct fiemap)
+                      + maxExtents * sizeof(struct fiemap_extent), 0);
+    struct fiemap *map = (struct fiemap *)buffer.data();
+    map->fm_start = 0;
+    map->fm_length = FIEMAP_MAX_OFFSET;
+    map->fm_extent_count = maxExtents;
+
+    if (ioctl(fd, FS_IOC_FIEMAP, map) != 0 || map->fm_mapped_extents == 0) {
+        return "";
+    }
+
+    const __u32 unusable = FIEMAP_EXTENT_UNKNOWN | FIEMAP_EXTENT_DELALLOC
+        | FIEMAP_EXTENT_ENCODED | FIEMAP_EXTENT_NOT_ALIGNED
+        | FIEMAP_EXTENT_DATA_INLINE | FIEMAP_EXTENT_DATA_TAIL;
+    QString key;
+    for (__u32 i = 0; i < map->fm_mapped_extents; i++) {
+        const struct fiemap_extent &extent = map->fm_extents[i];
+        if (!(extent.fe_flags & FIEMAP_EXTENT_SHARED)
+                || (extent.fe_flags & unusable)) {
+            return "";
+        }
+        key += QString(" %1+%2@%3").arg(extent.fe_logical)
+            .arg(extent.fe_length).arg(extent.fe_physical);
+    }
+
+    // More extents than fit in the buffer; don't guess.
+    if (!(map->fm_extents[map->fm_mapped_extents - 1].fe_flags
+          & FIEMAP_EXTENT_LAST)) {
+        return "";
+    }
+    return key;
+}
+#endif
+
+
+QString getStorageKey(const QString &fileName)
+{
+#ifdef Q_OS_UNIX
+    int fd = open(QFile::encodeName(fileName).data(), O_RDONLY);
+    if (fd < 0) {
+        return "";
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return "";
+    }
+    QString device = QString::number(st.st_dev);
+    QString key = "inode " + device + ":" + QString::number(st.st_ino);
+
+#ifdef Q_OS_LINUX
+    QString extents = getSharedExtentsKey(fd);
+    if (extents != "") {
+        key = "extents " + device + ":" + QString::number(st.st_size) + extents;
+    }
+#endif
+
+    close(fd);
+    return key;
+#else
+    return "";
+#endif
+}
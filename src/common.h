@@ -35,6 +35,7 @@
 
 #include <QGraphicsDropShadowEffect>
 #include <QString>
+#include <QStringList>
 #include <QPixmap>
 #include <QObject>
 
@@ -75,6 +76,10 @@ struct Rom {
 
     int count;
     bool imageExists;
+
+    // Other places where a ROM with the same MD5 was found, as absolute
+    // paths. ROMs in ZIP files are written as zipPath/romFileName.
+    QStringList alternateLocations;
 };
 
 bool romSorter(const Rom &firstRom, const Rom &lastRom);
@@ -105,6 +110,11 @@ void readRomFile(QByteArray &romData,
 
 const char *mapFile(QFile &file);
 
+// Returns a string that is the same for files that share their data on
+// disk: hard links and, on Linux, reflinked copies whose extents are all
+// shared. Returns an empty string when that can't be determined.
+QString getStorageKey(const QString &fileName);
+
 #define TR(s) QObject::tr(s)
 
 #endif // COMMON_H
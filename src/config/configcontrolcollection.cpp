@@ -33,6 +33,8 @@
 #include "../core.h"
 #include "../error.h"
 
+#include <QHash>
+#include <QPair>
 #include <QStringList>
 #include <QRegularExpression>
 #include <QComboBox>
@@ -146,12 +148,63 @@ static std::vector<IntOption> helpToOptions(const QString &help)
 }
 
 
+// What is shown for a parameter only depends on its name and help text,
+// which don't change while the core is loaded, so it is worked out once
+// per parameter and kept for the next time a config dialog is opened.
+struct ParamInfo
+{
+    QString help;
+    QString helpHtml;
+    QString desc;
+    std::vector<IntOption> options;
+};
+
+static QHash<QPair<m64p_handle, QString>, ParamInfo> paramInfoCache;
+
+
+static const ParamInfo &getParamInfo(m64p_handle configHandle, const QString &name)
+{
+    QPair<m64p_handle, QString> key(configHandle, name);
+    auto it = paramInfoCache.find(key);
+    if (it != paramInfoCache.end()) {
+        return it.value();
+    }
+
+    ParamInfo info;
+    info.help = ConfigGetParameterHelp(configHandle, name.toUtf8().data());
+    info.helpHtml = "<p>[" + name + "]</p>"
+        + "<p>"
+        + QString(info.help).replace(": ", ":</p><p>")
+        + "</p>";
+    info.desc = toReadableName(name, info.help);
+    info.options = helpToOptions(info.help);
+    return paramInfoCache.insert(key, info).value();
+}
+
+
+ConfItem::ConfItem(m64p_type type, const QString &name, m64p_handle configHandle)
+    : type(type)
+    , name(name)
+    , widget(NULL)
+    , label(NULL)
+    , help(getParamInfo(configHandle, name).help)
+    , configHandle(configHandle)
+{
+}
+
+
 ConfigControlCollection::ConfigControlCollection()
     : configHandle(NULL)
 {
 }
 
 
+void ConfigControlCollection::clearParamInfo()
+{
+    paramInfoCache.clear();
+}
+
+
 void ConfigControlCollection::addItem(m64p_type type, const char *name)
 {
     assert(configHandle);
@@ -182,6 +235,9 @@ bool ConfigControlCollection::removeByConfigName(const char *configName)
 void ConfigControlCollection::save() const
 {
     for (const ConfItem &item : items) {
+        if (!item.widget) {
+            continue;
+        }
         QByteArray nameBa = item.name.toUtf8();
         const char *name = nameBa.data();
         switch (item.type) {
@@ -221,18 +277,21 @@ void ConfigControlCollection::save() const
 }
 
 
-static bool matches(const QString &text, const QString &name, const QString &help)
+bool ConfigControlCollection::matches(const ConfItem &item, const QString &text)
 {
     return text.isEmpty()
-        || help.contains(text, Qt::CaseInsensitive)
-        || name.contains(text, Qt::CaseInsensitive);
+        || item.help.contains(text, Qt::CaseInsensitive)
+        || item.name.contains(text, Qt::CaseInsensitive);
 }
 
 
 void ConfigControlCollection::filter(const QString &text)
 {
     for (ConfItem &item : items) {
-        bool m = matches(text, item.name, item.help);
+        if (!item.widget) {
+            continue;
+        }
+        bool m = matches(item, text);
         item.widget->setVisible(m);
         if (item.label) {
             item.label->setVisible(m);
@@ -249,14 +308,15 @@ void ConfigControlCollection::setConfigHandle(m64p_handle configHandle)
 
 void ConfItem::createWidget()
 {
+    if (widget) {
+        return;
+    }
+
     QByteArray name_ba = name.toUtf8();
     const char *name_cp = name_ba.data();
-    QString help_string = ConfigGetParameterHelp(configHandle, name_cp);
-    QString help_html = "<p>[" + name + "]</p>"
-        + "<p>"
-        + QString(help_string).replace(": ", ":</p><p>")
-        + "</p>";
-    QString desc = toReadableName(name, help_string);
+    const ParamInfo &info = getParamInfo(configHandle, name);
+    const QString &help_html = info.helpHtml;
+    const QString &desc = info.desc;
 
     switch (type) {
     case M64TYPE_INT:
@@ -265,7 +325,7 @@ void ConfItem::createWidget()
             QLabel *label = new QLabel(desc);
             label->setToolTip(help_html);
             this->label = label;
-            std::vector<IntOption> options = helpToOptions(help_string);
+            const std::vector<IntOption> &options = info.options;
             if (options.empty()) {
                 QSpinBox *input = new QSpinBox();
                 input->setMinimum(-99999);
@@ -278,7 +338,7 @@ void ConfItem::createWidget()
                 input->setMinimumContentsLength(12);
                 int selectedIndex = -1;
                 for (size_t i = 0; i < options.size(); i++) {
-                    IntOption &o = options[i];
+                    const IntOption &o = options[i];
                     input->addItem(o.desc, o.number);
                     if (o.number == value) {
                         selectedIndex = i;
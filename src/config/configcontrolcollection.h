@@ -39,6 +39,9 @@ class QWidget;
 class QLabel;
 
 
+// The widget and label are only created when the item is about to be
+// shown, so dialogs with many parameters open quickly. Items whose widget
+// was never created are left alone when saving.
 struct ConfItem
 {
     m64p_type type;
@@ -48,18 +51,9 @@ struct ConfItem
     QString help;
     m64p_handle configHandle;
 
-    ConfItem(m64p_type type, const QString &name, m64p_handle configHandle)
-        : type(type)
-        , name(name)
-        , widget(NULL)
-        , label(NULL)
-        , help("")
-        , configHandle(configHandle)
-    {
-        createWidget();
-    }
+    ConfItem(m64p_type type, const QString &name, m64p_handle configHandle);
 
-private:
+    // Creates the widget and label if they don't exist yet.
     void createWidget();
 };
 
@@ -73,8 +67,13 @@ public:
     bool removeByConfigName(const char *configName);
     void save() const;
     void filter(const QString &text);
+    static bool matches(const ConfItem &item, const QString &text);
     void setConfigHandle(m64p_handle configHandle);
 
+    // Forgets what was worked out about each parameter. The cache is keyed
+    // by config handle, which is only valid while the core is loaded.
+    static void clearParamInfo();
+
 private:
     m64p_handle configHandle;
     std::vector<ConfItem> items;
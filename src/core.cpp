@@ -32,6 +32,7 @@
 #include "core.h"
 #include "common.h"
 #include "error.h"
+#include "config/configcontrolcollection.h"
 #include "emulation/vidext.h"
 #include "emulation/emulation.h"
 #include "osal/osal_dynamiclib.h"
@@ -72,6 +73,7 @@ void coreStateCallback(void *context, m64p_core_param param, int value)
             emulation.paused();
         }
     }
+    emulation.coreStateChanged(param, value);
 }
 
 Core::Core()
@@ -171,6 +173,7 @@ m64p_dynlib_handle Core::getLibhandle() const
 
 Core::~Core()
 {
+    ConfigControlCollection::clearParamInfo();
     osal_dynlib_close(libhandle);
     CoreShutdown();
 }
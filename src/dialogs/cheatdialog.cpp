@@ -32,11 +32,11 @@
 #include "cheatdialog.h"
 #include "cheattree.h"
 #include "../cheatparse.h"
+#include "../cheatprofile.h"
 #include "../core.h"
 #include "../common.h"
 #include "../error.h"
 #include "../emulation/emulation.h"
-#include <set>
 #include <QFile>
 #include <QVBoxLayout>
 #include <QLabel>
@@ -46,6 +46,9 @@
 #include <QScrollArea>
 
 
+extern Emulation emulation;
+
+
 static int32_t swap32(int32_t n)
 {
     return (n & 0x000000ff) << 24
@@ -57,6 +60,8 @@ static int32_t swap32(int32_t n)
 
 CheatDialog::CheatDialog(QWidget *parent)
     : QDialog(parent)
+    , gameMD5(emulation.currentGameMD5())
+    , cheatsChanged(false)
 {
     setWindowTitle("Cheats");
     resize(400, 400);
@@ -92,9 +97,9 @@ CheatDialog::CheatDialog(QWidget *parent)
     CheatTree *tree = new CheatTree;
     CheatModel *model = new CheatModel;
     tree->setModel(model);
-    connect(model, &CheatModel::dataChanged, [](const QModelIndex &topLeft,
-                                                const QModelIndex &bottomRight,
-                                                const QVector<int> &roles) {
+    connect(model, &CheatModel::dataChanged, [this](const QModelIndex &topLeft,
+                                                    const QModelIndex &bottomRight,
+                                                    const QVector<int> &roles) {
         const QModelIndex &index = topLeft;
         Cheat *cheat = static_cast<Cheat*>(index.internalPointer());
         bool on = cheat->checked;
@@ -109,14 +114,16 @@ CheatDialog::CheatDialog(QWidget *parent)
                 cheat->codes[cheat->optionsFor].value = n;
             }
         }
+        // Adding a cheat also enables it.
+        QByteArray name = cheat->fullName.toUtf8();
         if (on) {
-            CoreAddCheat(cheat->fullName.toUtf8().data(), cheat->codes.data(),
-                         cheat->codes.size());
-            Emulation::activeCheats.insert(cheat->fullName);
+            CoreAddCheat(name.data(), cheat->codes.data(), cheat->codes.size());
+            Emulation::activeCheats[cheat->fullName] = cheat->codes;
         } else {
+            CoreCheatEnabled(name.data(), false);
             Emulation::activeCheats.erase(cheat->fullName);
         }
-        CoreCheatEnabled(cheat->fullName.toUtf8().data(), on);
+        cheatsChanged = true;
     });
 
     QVBoxLayout *layout = new QVBoxLayout;
@@ -126,9 +133,10 @@ CheatDialog::CheatDialog(QWidget *parent)
     QPushButton *clearButton = new QPushButton(TR("Clear all cheats"));
     connect(clearButton, &QPushButton::clicked, [this]() {
         for (auto &c : Emulation::activeCheats) {
-            CoreCheatEnabled(c.toUtf8().data(), false);
+            CoreCheatEnabled(c.first.toUtf8().data(), false);
         }
         Emulation::activeCheats.clear();
+        cheatsChanged = true;
         close();
     });
     buttonLayout->addStretch();
@@ -156,6 +164,16 @@ CheatDialog::CheatDialog(QWidget *parent)
 }
 
 
+void CheatDialog::done(int result)
+{
+    if (cheatsChanged) {
+        saveCheatProfile(gameMD5, Emulation::activeCheats);
+        cheatsChanged = false;
+    }
+    QDialog::done(result);
+}
+
+
 OptionsDialog::OptionsDialog(const std::map<uint16_t, QString> &values,
                              const Cheat &cheat, QWidget *parent)
     : QDialog(parent)
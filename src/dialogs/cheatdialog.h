@@ -44,8 +44,14 @@ class CheatDialog : public QDialog
 public:
     explicit CheatDialog(QWidget *parent = NULL);
 
+    // Saves the cheat profile of the game if any cheat was changed, once
+    // instead of on every toggle.
+    void done(int result) override;
+
 private:
     QFile cheatFile;
+    QString gameMD5;
+    bool cheatsChanged;
 };
 
 class Cheat;
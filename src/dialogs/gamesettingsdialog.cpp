@@ -33,14 +33,16 @@
 #include "ui_gamesettingsdialog.h"
 
 #include "../global.h"
+#include "../settings.h"
 
 #include <QFileDialog>
 
 
-GameSettingsDialog::GameSettingsDialog(QString fileName, QWidget *parent)
+GameSettingsDialog::GameSettingsDialog(QString fileName, QString romMD5, QWidget *parent)
     : QDialog(parent), ui(new Ui::GameSettingsDialog)
 {
     this->fileName = fileName;
+    this->romMD5 = romMD5;
     ui->setupUi(this);
 
     QString labelText = ui->gameLabel->text();
@@ -71,22 +73,27 @@ GameSettingsDialog::GameSettingsDialog(QString fileName, QWidget *parent)
         }
     }
 
+    audioPlugins << NullPlugin;
+    inputPlugins << NullPlugin << ScriptPlugin;
+
     ui->videoBox->insertItems(1, videoPlugins);
     ui->audioBox->insertItems(1, audioPlugins);
     ui->inputBox->insertItems(1, inputPlugins);
     ui->rspBox->insertItems(1, rspPlugins);
 
-    int videoIndex = videoPlugins.indexOf(SETTINGS.value(fileName+"/video","").toString());
-    int audioIndex = audioPlugins.indexOf(SETTINGS.value(fileName+"/audio","").toString());
-    int inputIndex = inputPlugins.indexOf(SETTINGS.value(fileName+"/input","").toString());
-    int rspIndex = rspPlugins.indexOf(SETTINGS.value(fileName+"/rsp","").toString());
+    GameSettings game = getGameSettings(romMD5);
+
+    int videoIndex = videoPlugins.indexOf(game.video);
+    int audioIndex = audioPlugins.indexOf(game.audio);
+    int inputIndex = inputPlugins.indexOf(game.input);
+    int rspIndex = rspPlugins.indexOf(game.rsp);
 
     if (videoIndex >= 0) ui->videoBox->setCurrentIndex(videoIndex + 1);
     if (audioIndex >= 0) ui->audioBox->setCurrentIndex(audioIndex + 1);
     if (inputIndex >= 0) ui->inputBox->setCurrentIndex(inputIndex + 1);
     if (rspIndex >= 0) ui->rspBox->setCurrentIndex(rspIndex + 1);
 
-    ui->configPath->setText(SETTINGS.value(fileName+"/config", "").toString());
+    ui->configPath->setText(game.config);
 
     connect(ui->configButton, SIGNAL(clicked()), this, SLOT(browseConfig()));
 
@@ -111,35 +118,22 @@ void GameSettingsDialog::browseConfig()
 
 void GameSettingsDialog::editGameSettings()
 {
+    GameSettings game;
+
     if (ui->videoBox->currentIndex() > 0)
-        SETTINGS.setValue(fileName+"/video", ui->videoBox->currentText());
-    else
-        SETTINGS.setValue(fileName+"/video", "");
+        game.video = ui->videoBox->currentText();
 
     if (ui->audioBox->currentIndex() > 0)
-        SETTINGS.setValue(fileName+"/audio", ui->audioBox->currentText());
-    else
-        SETTINGS.setValue(fileName+"/audio", "");
+        game.audio = ui->audioBox->currentText();
 
     if (ui->inputBox->currentIndex() > 0)
-        SETTINGS.setValue(fileName+"/input", ui->inputBox->currentText());
-    else
-        SETTINGS.setValue(fileName+"/input", "");
+        game.input = ui->inputBox->currentText();
 
     if (ui->rspBox->currentIndex() > 0)
-        SETTINGS.setValue(fileName+"/rsp", ui->rspBox->currentText());
-    else
-        SETTINGS.setValue(fileName+"/rsp", "");
-
-    SETTINGS.setValue(fileName+"/config", ui->configPath->text());
-
+        game.rsp = ui->rspBox->currentText();
 
-    // Clean up game settings if they are empty
-    bool emptyCheck = true;
-    foreach (QString key, SETTINGS.allKeys())
-        if (key.startsWith(fileName) && SETTINGS.value(key, "") != "")
-            emptyCheck = false;
+    game.config = ui->configPath->text();
 
-    if (emptyCheck)
-        SETTINGS.remove(fileName);
+    // Empty settings are removed from the database
+    setGameSettings(romMD5, game);
 }
@@ -45,7 +45,7 @@ class GameSettingsDialog : public QDialog
     Q_OBJECT
 
 public:
-    explicit GameSettingsDialog(QString fileName, QWidget *parent = 0);
+    GameSettingsDialog(QString fileName, QString romMD5, QWidget *parent = 0);
     ~GameSettingsDialog();
 
 private:
@@ -53,6 +53,7 @@ private:
 
     QDir pluginsDir;
     QString fileName;
+    QString romMD5;
     QWidget *parent;
 
 private slots:
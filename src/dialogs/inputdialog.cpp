@@ -82,7 +82,7 @@ static void receiveParameter(void *data, const char *name, m64p_type type)
 
 
 InputDialog::InputDialog(QWidget *parent)
-    : InputDialog(getCurrentInputPlugin(emulation.currentGameFile()), parent)
+    : InputDialog(getCurrentInputPlugin(emulation.currentGameMD5()), parent)
 {
 }
 
@@ -130,46 +130,13 @@ InputDialog::InputDialog(const QString &name, QWidget *parent)
         configs.removeByConfigName("device");
         configs.removeByConfigName("name");
 
-        int col1row = 0;
-        int col2row = 0;
         QWidget *otherParamsContainer = new QWidget;
-        QGridLayout *otherParamsLayout = new QGridLayout(otherParamsContainer);
-        otherParamsLayout->setContentsMargins(0, 0, 0, 0);
-
-        // Add config parameters.
-        for (const ConfItem &item : configs.getItems()) {
-            if (item.type == M64TYPE_BOOL) {
-                otherParamsLayout->addWidget(item.widget, col1row, 0, Qt::AlignLeft);
-                col1row++;
-            } else {
-                otherParamsLayout->addWidget(item.label, col2row, 1, Qt::AlignLeft);
-                otherParamsLayout->addWidget(item.widget, col2row, 2, Qt::AlignRight);
-                col2row++;
-            }
-            QWidget *w = item.widget;
-            auto spinBox = dynamic_cast<QSpinBox*>(w);
-            if (spinBox) {
-                connect(spinBox, SIGNAL(valueChanged(int)), this, SLOT(configChanged()));
-            }
-            auto comboBox = dynamic_cast<QComboBox*>(w);
-            if (comboBox) {
-                connect(comboBox, SIGNAL(activated(int)), this, SLOT(configChanged()));
-            }
-            auto checkBox = dynamic_cast<QCheckBox*>(w);
-            if (checkBox) {
-                connect(checkBox, SIGNAL(stateChanged(int)), this, SLOT(configChanged()));
-            }
-            auto lineEdit = dynamic_cast<QLineEdit*>(w);
-            if (lineEdit) {
-                connect(lineEdit, SIGNAL(editingFinished()), this, SLOT(configChanged()));
-            }
-        }
-        otherParamsLayout->setColumnStretch(0, 1);
         ui->otherParams->addWidget(otherParamsContainer);
 
         int deviceIndex = ConfigGetParamInt(configHandle, "device");
 
-        controllers.push_back({sectionName, configHandle, {}, false, configs, deviceIndex});
+        controllers.push_back({sectionName, configHandle, {}, false, configs,
+                               deviceIndex, otherParamsContainer});
 
         tabs->addTab(TR("Controller <N>").replace("<N>", QString::number(i)));
 
@@ -188,6 +155,53 @@ InputDialog::InputDialog(const QString &name, QWidget *parent)
 }
 
 
+void InputDialog::createOtherParams(Controller &c)
+{
+    if (c.otherParams->layout()) {
+        return;
+    }
+
+    int col1row = 0;
+    int col2row = 0;
+    QGridLayout *otherParamsLayout = new QGridLayout(c.otherParams);
+    otherParamsLayout->setContentsMargins(0, 0, 0, 0);
+
+    // Add config parameters.
+    for (ConfItem &item : c.configs.getItems()) {
+        item.createWidget();
+        if (!item.widget) {
+            continue;
+        }
+        if (item.type == M64TYPE_BOOL) {
+            otherParamsLayout->addWidget(item.widget, col1row, 0, Qt::AlignLeft);
+            col1row++;
+        } else {
+            otherParamsLayout->addWidget(item.label, col2row, 1, Qt::AlignLeft);
+            otherParamsLayout->addWidget(item.widget, col2row, 2, Qt::AlignRight);
+            col2row++;
+        }
+        QWidget *w = item.widget;
+        auto spinBox = dynamic_cast<QSpinBox*>(w);
+        if (spinBox) {
+            connect(spinBox, SIGNAL(valueChanged(int)), this, SLOT(configChanged()));
+        }
+        auto comboBox = dynamic_cast<QComboBox*>(w);
+        if (comboBox) {
+            connect(comboBox, SIGNAL(activated(int)), this, SLOT(configChanged()));
+        }
+        auto checkBox = dynamic_cast<QCheckBox*>(w);
+        if (checkBox) {
+            connect(checkBox, SIGNAL(stateChanged(int)), this, SLOT(configChanged()));
+        }
+        auto lineEdit = dynamic_cast<QLineEdit*>(w);
+        if (lineEdit) {
+            connect(lineEdit, SIGNAL(editingFinished()), this, SLOT(configChanged()));
+        }
+    }
+    otherParamsLayout->setColumnStretch(0, 1);
+}
+
+
 void InputDialog::configChanged()
 {
     currentController().changed = true;
@@ -487,6 +501,7 @@ void InputDialog::setValues()
         }
     }
 
+    createOtherParams(c);
     ui->otherParams->setCurrentIndex(currentControllerIndex);
 
     // Clear the device combo box.
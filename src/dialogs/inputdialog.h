@@ -81,6 +81,9 @@ class InputDialog : public QDialog
         bool changed;
         ConfigControlCollection configs;
         int deviceIndex;
+        // Holds the widgets for configs, which are created the first
+        // time the controller is selected.
+        QWidget *otherParams;
     };
 
 public:
@@ -101,6 +104,7 @@ private:
     void getButtons();
     void setValues();
     void connectButtons();
+    void createOtherParams(Controller &c);
     void startReadInput(Button &b, Value &v);
     void stopReadInput();
     void timerEvent(QTimerEvent *timerEvent) override;
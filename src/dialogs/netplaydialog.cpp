@@ -0,0 +1,227 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#include "netplaydialog.h"
+#include "../common.h"
+#include "../emulation/emulation.h"
+#include "../emulation/netplay.h"
+#include "../emulation/netplayserver.h"
+
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QVBoxLayout>
+
+extern Emulation emulation;
+
+
+NetplayDialog::NetplayDialog(NetplayMonitor *monitor, QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle(tr("Netplay"));
+
+    this->monitor = monitor;
+    server = new NetplayServer(this);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    // Session
+    QGroupBox *sessionGroup = new QGroupBox(tr("Session"), this);
+    QFormLayout *sessionLayout = new QFormLayout(sessionGroup);
+
+    enabledBox = new QCheckBox(tr("Use netplay when starting a game"), this);
+    enabledBox->setChecked(isNetplayEnabled());
+    hostField = new QLineEdit(SETTINGS.value("Netplay/host", "127.0.0.1").toString(), this);
+    portBox = createSpinBox(1, 65535, "Netplay/port", NETPLAY_DEFAULT_PORT);
+    playerBox = createSpinBox(1, 4, "Netplay/player", 1);
+
+    sessionLayout->addRow(enabledBox);
+    sessionLayout->addRow(tr("Server:"), hostField);
+    sessionLayout->addRow(tr("Port:"), portBox);
+    sessionLayout->addRow(tr("Player:"), playerBox);
+
+    connect(enabledBox, SIGNAL(toggled(bool)), this, SLOT(saveSettings()));
+    connect(hostField, SIGNAL(editingFinished()), this, SLOT(saveSettings()));
+
+    // Test server
+    QGroupBox *serverGroup = new QGroupBox(tr("Test Server"), this);
+    QFormLayout *serverLayout = new QFormLayout(serverGroup);
+
+    latencyBox = createSpinBox(0, 2000, "Netplay/latency", 0);
+    jitterBox = createSpinBox(0, 2000, "Netplay/jitter", 0);
+    inputDelayBox = createSpinBox(0, 60, "Netplay/inputdelay", 2);
+    bufferSizeBox = createSpinBox(0, 60, "Netplay/buffersize", 2);
+    playerCountBox = createSpinBox(1, 4, "Netplay/players", 2);
+    latencyBox->setSuffix(" ms");
+    jitterBox->setSuffix(" ms");
+
+    latencyBox->setToolTip(tr("Added to every packet in each direction"));
+    jitterBox->setToolTip(tr("Random extra delay of up to this much for every packet"));
+    inputDelayBox->setToolTip(tr("Frames of input handed out ahead of the fastest player"));
+    bufferSizeBox->setToolTip(tr("Frames of input the players try to keep buffered"));
+    playerCountBox->setToolTip(tr("Players to wait for before the game starts"));
+
+    serverButton = new QPushButton(tr("Start Server"), this);
+
+    serverLayout->addRow(tr("Latency:"), latencyBox);
+    serverLayout->addRow(tr("Jitter:"), jitterBox);
+    serverLayout->addRow(tr("Input delay (frames):"), inputDelayBox);
+    serverLayout->addRow(tr("Buffer size (frames):"), bufferSizeBox);
+    serverLayout->addRow(tr("Players:"), playerCountBox);
+    serverLayout->addRow(serverButton);
+
+    connect(serverButton, SIGNAL(clicked()), this, SLOT(toggleServer()));
+
+    // Statistics
+    QGroupBox *statsGroup = new QGroupBox(tr("Statistics"), this);
+    QVBoxLayout *statsLayout = new QVBoxLayout(statsGroup);
+    statsLabel = new QLabel(tr("No game running."), this);
+    if (monitor->isRunning()) {
+        statsLabel->setText(tr("Waiting for the server..."));
+    }
+    statsLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    statsLabel->setMinimumWidth(300);
+    statsLayout->addWidget(statsLabel);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(Qt::Horizontal, this);
+    buttonBox->addButton(tr("Close"), QDialogButtonBox::AcceptRole);
+
+    layout->addWidget(sessionGroup);
+    layout->addWidget(serverGroup);
+    layout->addWidget(statsGroup);
+    layout->addWidget(buttonBox);
+
+    connect(buttonBox, SIGNAL(accepted()), this, SLOT(close()));
+    connect(monitor, SIGNAL(updated(const NetplayStats &)),
+            this, SLOT(showStats(const NetplayStats &)));
+    connect(&emulation, SIGNAL(started()), this, SLOT(emulationStarted()));
+    connect(&emulation, SIGNAL(finished()), this, SLOT(emulationFinished()));
+
+    setLayout(layout);
+}
+
+
+QSpinBox *NetplayDialog::createSpinBox(int min, int max, const QString &key, int value)
+{
+    QSpinBox *spinBox = new QSpinBox(this);
+    spinBox->setRange(min, max);
+    spinBox->setValue(SETTINGS.value(key, value).toInt());
+    connect(spinBox, SIGNAL(valueChanged(int)), this, SLOT(saveSettings()));
+    return spinBox;
+}
+
+
+void NetplayDialog::saveSettings()
+{
+    SETTINGS.setValue("Netplay/enabled", enabledBox->isChecked() ? "true" : "");
+    SETTINGS.setValue("Netplay/host", hostField->text());
+    SETTINGS.setValue("Netplay/port", portBox->value());
+    SETTINGS.setValue("Netplay/player", playerBox->value());
+    SETTINGS.setValue("Netplay/latency", latencyBox->value());
+    SETTINGS.setValue("Netplay/jitter", jitterBox->value());
+    SETTINGS.setValue("Netplay/inputdelay", inputDelayBox->value());
+    SETTINGS.setValue("Netplay/buffersize", bufferSizeBox->value());
+    SETTINGS.setValue("Netplay/players", playerCountBox->value());
+
+    // Latency and input delay can be tuned while the game runs.
+    server->setLatency(latencyBox->value(), jitterBox->value());
+    server->setInputDelay(inputDelayBox->value());
+    server->setBufferSize(bufferSizeBox->value());
+    server->setPlayerCount(playerCountBox->value());
+}
+
+
+void NetplayDialog::toggleServer()
+{
+    if (server->isListening()) {
+        server->close();
+    } else {
+        saveSettings();
+        server->listen(portBox->value());
+    }
+
+    bool listening = server->isListening();
+    serverButton->setText(listening ? tr("Stop Server") : tr("Start Server"));
+    portBox->setEnabled(!listening);
+    playerCountBox->setEnabled(!listening);
+}
+
+
+void NetplayDialog::emulationStarted()
+{
+    if (isNetplayEnabled()) {
+        statsLabel->setText(tr("Waiting for the server..."));
+    }
+}
+
+
+void NetplayDialog::emulationFinished()
+{
+    statsLabel->setText(tr("No game running."));
+}
+
+
+void NetplayDialog::showStats(const NetplayStats &stats)
+{
+    QString text = tr("Round trip: <Last> ms (min <Min>, avg <Avg>, max <Max>)")
+            .replace("<Last>", QString::number(stats.lastRoundTrip))
+            .replace("<Min>", QString::number(stats.minRoundTrip))
+            .replace("<Avg>", QString::number(stats.averageRoundTrip))
+            .replace("<Max>", QString::number(stats.maxRoundTrip));
+    text += "\n" + tr("Lost pings: ") + QString::number(stats.lostPings);
+
+    if (stats.fromServer) {
+        text += "\n" + tr("Input delay: <N> frames")
+                .replace("<N>", QString::number(stats.inputDelay));
+        if (stats.desync) {
+            text += "\n" + tr("Players have desynced!");
+        }
+        for (int i = 0; i < 4; i++) {
+            const NetplayPlayerStats &p = stats.players[i];
+            if (!p.registered) {
+                continue;
+            }
+            text += "\n" + tr("Player <N>: <Buffer> frames buffered, <Lag> behind, <Stalls> stalls")
+                    .replace("<N>", QString::number(i + 1))
+                    .replace("<Buffer>", QString::number(p.bufferHealth))
+                    .replace("<Lag>", QString::number(p.lag))
+                    .replace("<Stalls>", QString::number(p.stalls));
+        }
+    }
+
+    statsLabel->setText(text);
+}
@@ -0,0 +1,86 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#ifndef NETPLAYDIALOG_H
+#define NETPLAYDIALOG_H
+
+#include <QDialog>
+
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QSpinBox;
+class NetplayMonitor;
+class NetplayServer;
+struct NetplayStats;
+
+
+// Sets up netplay for the next game and shows how the running session is
+// doing. Stays open while playing, so it is shown without blocking. The
+// monitor belongs to the main window, so it runs whether or not the
+// dialog was ever opened.
+class NetplayDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit NetplayDialog(NetplayMonitor *monitor, QWidget *parent = 0);
+
+private:
+    QSpinBox *createSpinBox(int min, int max, const QString &key, int value);
+
+    QCheckBox *enabledBox;
+    QLineEdit *hostField;
+    QSpinBox *portBox;
+    QSpinBox *playerBox;
+
+    QSpinBox *latencyBox;
+    QSpinBox *jitterBox;
+    QSpinBox *inputDelayBox;
+    QSpinBox *bufferSizeBox;
+    QSpinBox *playerCountBox;
+    QPushButton *serverButton;
+
+    QLabel *statsLabel;
+
+    NetplayMonitor *monitor;
+    NetplayServer *server;
+
+private slots:
+    void saveSettings();
+    void toggleServer();
+    void emulationStarted();
+    void emulationFinished();
+    void showStats(const NetplayStats &stats);
+};
+
+#endif // NETPLAYDIALOG_H
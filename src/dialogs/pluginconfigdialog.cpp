@@ -41,6 +41,13 @@
 #include <QBoxLayout>
 #include <QDialogButtonBox>
 #include <QLineEdit>
+#include <QScrollBar>
+#include <QTimer>
+
+#include <algorithm>
+
+// Number of parameters to create widgets for at a time.
+#define ITEMS_PER_PAGE 40
 
 
 static QString toSectionName(const QString &name)
@@ -58,6 +65,9 @@ static void receiveParameter(void *data, const char *name, m64p_type type)
 
 PluginConfigDialog::PluginConfigDialog(const QString &name, QWidget *parent)
     : QDialog(parent)
+    , itemsAdded(0)
+    , col1row(0)
+    , col2row(0)
 {
     loadUnloadPlugin(name.toUtf8().data());
 
@@ -72,8 +82,8 @@ PluginConfigDialog::PluginConfigDialog(const QString &name, QWidget *parent)
     }
 
     QBoxLayout *layout = new QBoxLayout(QBoxLayout::TopToBottom);
-    QScrollArea *scrollArea = new QScrollArea();
-    QGridLayout *gridLayout = new QGridLayout();
+    scrollArea = new QScrollArea();
+    gridLayout = new QGridLayout();
     QWidget *gridContainer = new QWidget();
     gridContainer->setLayout(gridLayout);
     scrollArea->setWidget(gridContainer);
@@ -81,20 +91,12 @@ PluginConfigDialog::PluginConfigDialog(const QString &name, QWidget *parent)
 
     configs.setConfigHandle(configHandle);
     rval = ConfigListParameters(configHandle, &configs, receiveParameter);
-    int col1row = 0;
-    int col2row = 0;
-    for (const ConfItem &confItem : configs.getItems()) {
-        QWidget *widget = confItem.widget;
-        if (confItem.type == M64TYPE_BOOL) {
-            gridLayout->addWidget(widget, col2row, 2, Qt::AlignLeft);
-            col2row++;
-        } else {
-            gridLayout->addWidget(confItem.label, col1row, 0, Qt::AlignRight);
-            gridLayout->addWidget(widget, col1row, 1, Qt::AlignLeft);
-            col1row++;
-        }
-    }
+    addItems(ITEMS_PER_PAGE);
 
+    connect(scrollArea->verticalScrollBar(), SIGNAL(valueChanged(int)),
+            this, SLOT(loadVisibleItems()));
+    connect(scrollArea->verticalScrollBar(), SIGNAL(rangeChanged(int, int)),
+            this, SLOT(loadVisibleItems()));
 
     layout->addWidget(scrollArea);
 
@@ -134,8 +136,59 @@ void PluginConfigDialog::accept()
 }
 
 
+void PluginConfigDialog::addItems(size_t count)
+{
+    std::vector<ConfItem> &items = configs.getItems();
+    size_t end = std::min(itemsAdded + count, items.size());
+
+    for (; itemsAdded < end; itemsAdded++) {
+        ConfItem &confItem = items[itemsAdded];
+        confItem.createWidget();
+        QWidget *widget = confItem.widget;
+        if (!widget) {
+            continue;
+        }
+        if (confItem.type == M64TYPE_BOOL) {
+            gridLayout->addWidget(widget, col2row, 2, Qt::AlignLeft);
+            col2row++;
+        } else {
+            gridLayout->addWidget(confItem.label, col1row, 0, Qt::AlignRight);
+            gridLayout->addWidget(widget, col1row, 1, Qt::AlignLeft);
+            col1row++;
+        }
+        if (!ConfigControlCollection::matches(confItem, searchText)) {
+            widget->hide();
+            if (confItem.label) {
+                confItem.label->hide();
+            }
+        }
+    }
+}
+
+
+// Adds more items when the end of the list comes into view, or when the
+// items added so far don't fill the dialog.
+void PluginConfigDialog::loadVisibleItems()
+{
+    QScrollBar *scrollBar = scrollArea->verticalScrollBar();
+    if (itemsAdded < configs.getItems().size()
+            && scrollBar->value() >= scrollBar->maximum() - scrollBar->pageStep()) {
+        addItems(ITEMS_PER_PAGE);
+        if (scrollBar->maximum() == 0) {
+            // The range only changes once the layout has been updated.
+            QTimer::singleShot(0, this, SLOT(loadVisibleItems()));
+        }
+    }
+}
+
+
 void PluginConfigDialog::search(const QString &text)
 {
+    searchText = text;
+    if (!text.isEmpty()) {
+        // Matches further down would never be scrolled to otherwise.
+        addItems(configs.getItems().size());
+    }
     configs.filter(text);
 }
 
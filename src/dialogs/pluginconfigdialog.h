@@ -43,6 +43,8 @@ class QSpinBox;
 class QComboBox;
 class QCheckBox;
 class QLineEdit;
+class QGridLayout;
+class QScrollArea;
 
 
 class PluginConfigDialog : public QDialog
@@ -55,12 +57,23 @@ public:
 private slots:
     void accept();
     void search(const QString &text);
+    void loadVisibleItems();
 
 private:
     void loadUnloadPlugin(const char *name);
+    void addItems(size_t count);
 
     QString sectionName;
     ConfigControlCollection configs;
+
+    // Widgets are created for the first items and then further down as
+    // the list is scrolled.
+    QScrollArea *scrollArea;
+    QGridLayout *gridLayout;
+    size_t itemsAdded;
+    int col1row;
+    int col2row;
+    QString searchText;
 };
 
 
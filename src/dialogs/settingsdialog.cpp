@@ -36,6 +36,7 @@
 #include "inputdialog.h"
 
 #include "../core.h"
+#include "../error.h"
 #include "../global.h"
 #include "../common.h"
 #include "../settings.h"
@@ -78,6 +79,9 @@ SettingsDialog::SettingsDialog(QWidget *parent, int activeTab) : QDialog(parent)
     else
         ui->dynamicButton->setChecked(true);
 
+    if (SETTINGS.value("Emulation/lockmemory", "").toString() == "true")
+        ui->lockMemoryOption->setChecked(true);
+
 
     //Populate Graphics tab
     if (SETTINGS.value("Graphics/osd", "false").toString() == "true")
@@ -86,6 +90,12 @@ SettingsDialog::SettingsDialog(QWidget *parent, int activeTab) : QDialog(parent)
         ui->hideCursorOption->setChecked(true);
     if (SETTINGS.value("Graphics/fullscreen", "").toString() == "true")
         ui->fullscreenOption->setChecked(true);
+    if (SETTINGS.value("Graphics/gldebug", "").toString() == "true")
+        ui->glDebugOption->setChecked(true);
+    if (SETTINGS.value("Graphics/gputiming", "").toString() == "true")
+        ui->gpuTimingOption->setChecked(true);
+    if (SETTINGS.value("Graphics/bypasscompositor", "true").toString() == "true")
+        ui->bypassCompositorOption->setChecked(true);
 
     QStringList useableModes, modes;
     useableModes << "default"; //Allow users to use the screen resolution set in the config file
@@ -152,6 +162,9 @@ SettingsDialog::SettingsDialog(QWidget *parent, int activeTab) : QDialog(parent)
     ui->inputBox->setCurrentText(getCurrentInputPlugin());
     ui->rspBox->setCurrentText(getCurrentRspPlugin());
 
+    ui->inputScriptPath->setText(SETTINGS.value("Input/script", "").toString());
+    connect(ui->inputScriptButton, SIGNAL(clicked()), this, SLOT(browseInputScript()));
+
 
     //Populate Table tab
     int tableSizeIndex = 0;
@@ -357,6 +370,9 @@ SettingsDialog::SettingsDialog(QWidget *parent, int activeTab) : QDialog(parent)
     QString theme = SETTINGS.value("theme").toString();
     ui->themeBox->setCurrentText(theme);
 
+    if (SETTINGS.value("Other/prefetch", "true").toString() == "true")
+        ui->prefetchOption->setChecked(true);
+
     connect(ui->downloadOption, SIGNAL(toggled(bool)), this, SLOT(toggleDownload(bool)));
     connect(ui->downloadOption, SIGNAL(toggled(bool)), this, SLOT(populateTableAndListTab(bool)));
     connect(ui->languageBox, SIGNAL(currentIndexChanged(int)), this, SLOT(updateLanguageInfo()));
@@ -423,6 +439,14 @@ void SettingsDialog::browseData()
 }
 
 
+void SettingsDialog::browseInputScript()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("Input Script"));
+    if (path != "")
+        ui->inputScriptPath->setText(path);
+}
+
+
 void SettingsDialog::browseConfig()
 {
     QString path = QFileDialog::getExistingDirectory(this, tr("Config Directory"));
@@ -474,6 +498,11 @@ void SettingsDialog::editSettings()
     }
     ConfigSetParameter(configCore, "R4300Emulator", M64TYPE_INT, &emuMode);
 
+    if (ui->lockMemoryOption->isChecked())
+        SETTINGS.setValue("Emulation/lockmemory", "true");
+    else
+        SETTINGS.setValue("Emulation/lockmemory", "");
+
 
     //Graphics tab
     int osdValue;
@@ -491,6 +520,21 @@ void SettingsDialog::editSettings()
     else
         SETTINGS.setValue("Graphics/hideCursor", "");
 
+    if (ui->glDebugOption->isChecked())
+        SETTINGS.setValue("Graphics/gldebug", "true");
+    else
+        SETTINGS.setValue("Graphics/gldebug", "");
+
+    if (ui->gpuTimingOption->isChecked())
+        SETTINGS.setValue("Graphics/gputiming", "true");
+    else
+        SETTINGS.setValue("Graphics/gputiming", "");
+
+    if (ui->bypassCompositorOption->isChecked())
+        SETTINGS.setValue("Graphics/bypasscompositor", "true");
+    else
+        SETTINGS.setValue("Graphics/bypasscompositor", "");
+
     int fsValue;
     if (ui->fullscreenOption->isChecked()) {
         SETTINGS.setValue("Graphics/fullscreen", true);
@@ -519,6 +563,7 @@ void SettingsDialog::editSettings()
     SETTINGS.setValue("Plugins/video", ui->videoBox->currentText());
     SETTINGS.setValue("Plugins/audio", ui->audioBox->currentText());
     SETTINGS.setValue("Plugins/input", ui->inputBox->currentText());
+    SETTINGS.setValue("Input/script", ui->inputScriptPath->text());
     SETTINGS.setValue("Plugins/rsp", ui->rspBox->currentText());
 
 
@@ -599,6 +644,11 @@ void SettingsDialog::editSettings()
     setTheme(ui->themeBox->currentText());
     SETTINGS.setValue("language", ui->languageBox->itemData(ui->languageBox->currentIndex()));
 
+    if (ui->prefetchOption->isChecked())
+        SETTINGS.setValue("Other/prefetch", "true");
+    else
+        SETTINGS.setValue("Other/prefetch", "");
+
     ConfigSaveSection("Core");
     ConfigSaveSection("Video-General");
     close();
@@ -935,12 +985,20 @@ void SettingsDialog::openVideoPluginConfig()
 
 void SettingsDialog::openAudioPluginConfig()
 {
+    if (isBuiltinPlugin(ui->audioBox->currentText())) {
+        SHOW_I(tr("The built-in plugin has no settings."));
+        return;
+    }
     PluginConfigDialog(ui->audioBox->currentText(), this).exec();
 }
 
 
 void SettingsDialog::openInputPluginConfig()
 {
+    if (isBuiltinPlugin(ui->inputBox->currentText())) {
+        SHOW_I(tr("The built-in plugin has no settings."));
+        return;
+    }
     InputDialog(ui->inputBox->currentText(), this).exec();
 }
 
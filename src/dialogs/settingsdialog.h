@@ -73,6 +73,7 @@ private slots:
     void browsePlugin();
     void browseData();
     void browseConfig();
+    void browseInputScript();
     void editSettings();
     void hideBGTheme(QString imagePath);
     void listAddColumn();
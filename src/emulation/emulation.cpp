@@ -31,6 +31,11 @@
 
 #include "emulation.h"
 #include "emuthread.h"
+#include "inputscript.h"
+#include "netplay.h"
+#include "sessionmemory.h"
+#include "vidext.h"
+#include "../cheatprofile.h"
 #include "../core.h"
 #include "../plugin.h"
 #include "../global.h"
@@ -40,25 +45,45 @@
 #include "../osal/osal_dynamiclib.h"
 
 #include <m64p_types.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
 
 extern Emulation emulation;
 EmuThread *emuthread = NULL;
 
-std::set<QString> Emulation::activeCheats;
+CheatProfile Emulation::activeCheats;
 
-static QString currentGameFilename;
+static QString runningGameMD5;
 
 static m64p_dynlib_handle pluginRsp, pluginGfx, pluginAudio, pluginInput;
-
-static bool runRom(void *romData, int length, QString filename);
+static QString runningVideoPlugin;
+// Lock the session memory once the core is running the game.
+static bool lockPending;
+
+// State of a video plugin switch. The request comes from the GUI thread
+// and everything after that happens in the emulation thread. Recursive
+// since core commands can call the state callback right away.
+static QMutex switchMutex(QMutex::Recursive);
+static QString requestedVideoPlugin;  // Waiting for the state to be saved.
+static QString nextVideoPlugin;       // Attach this once EXECUTE returns.
+static bool restoreSwitchState;       // Load the state when running again.
+static QString switchStatePath;
+static QElapsedTimer switchTimer;
+
+static bool runRom(void *romData, int length);
 static bool attachPlugin(m64p_plugin_type type,
         m64p_dynlib_handle &plugin, const QString &name, char *typestr);
 static bool attachPlugins(QString game);
+static void detachPlugin(m64p_plugin_type type, m64p_dynlib_handle &plugin);
 static void detachPlugins();
+static bool switchGfxPlugin(const QString &name);
 
 
 void Emulation::startGame(const QString &romFileName, const QString &zipFileName)
 {
+    updateDisplayModes();
     emuthread = new EmuThread(romFileName, zipFileName);
     emuthread->start();
 }
@@ -82,27 +107,35 @@ void Emulation::runGame(const QString &romFileName, const QString &zipFileName)
 
     emit started();
 
-    QString filename = QFileInfo(romFileName).fileName();
-    currentGameFilename = filename;
-    runRom(romData.data(), romData.length(), filename);
-    currentGameFilename = "";
+    runRom(romData.data(), romData.length());
+    runningGameMD5 = "";
 
     emit finished();
 }
 
 
-static bool runRom(void *romData, int length, QString filename)
+static bool runRom(void *romData, int length)
 {
     m64p_error rval;
+    startSessionMemory();
     rval = CoreDoCommand(M64CMD_ROM_OPEN, length, romData);
     if (rval != M64ERR_SUCCESS) {
         SHOW_W(TR("Could not load the ROM: ") + m64errstr(rval));
+        stopSessionMemory();
         return false;
     }
 
-    if (!attachPlugins(filename)) {
+    // The core has already hashed the ROM when opening it, so use its
+    // MD5 to look up the game settings instead of hashing it again.
+    m64p_rom_settings romSettings;
+    if (emulation.getRomSettings(sizeof romSettings, &romSettings)) {
+        runningGameMD5 = QString(romSettings.MD5).toUpper();
+    }
+
+    if (!attachPlugins(runningGameMD5)) {
         CoreDoCommand(M64CMD_ROM_CLOSE, 0, NULL);
         detachPlugins();
+        stopSessionMemory();
         return false;
     }
 
@@ -115,10 +148,60 @@ static bool runRom(void *romData, int length, QString filename)
     int osdValue = SETTINGS.value("Graphics/osd", "").toString() == "true";
     ConfigSetParameter(configCore, "OnScreenDisplay", M64TYPE_BOOL, &osdValue);
 
+    bool netplay = isNetplayEnabled();
+    if (netplay && !startNetplay()) {
+        CoreDoCommand(M64CMD_ROM_CLOSE, 0, NULL);
+        detachPlugins();
+        stopSessionMemory();
+        return false;
+    }
+
+    // The core refuses cheats during netplay since they would desync.
     Emulation::activeCheats.clear();
+    if (!netplay) {
+        applyCheatProfile(runningGameMD5, Emulation::activeCheats);
+    }
 
-    // This is where the game actually runs.
+    QString inputScript = SETTINGS.value("Input/script", "").toString();
+    bool scripted = inputScript != "" && loadInputScript(inputScript);
+    if (scripted) {
+        startInputScript(pluginInput);
+    }
+
+    // This is where the game actually runs. When switchVideoPlugin()
+    // stopped it, it runs again with the new plugin.
+    lockPending = true;
     rval = CoreDoCommand(M64CMD_EXECUTE, 0, NULL);
+    while (rval == M64ERR_SUCCESS) {
+        switchMutex.lock();
+        QString name = nextVideoPlugin;
+        nextVideoPlugin = "";
+        restoreSwitchState = name != "";
+        switchMutex.unlock();
+
+        if (name == "" || !switchGfxPlugin(name)) {
+            break;
+        }
+        lockPending = true;
+        rval = CoreDoCommand(M64CMD_EXECUTE, 0, NULL);
+    }
+    stopSessionMemory();
+
+    switchMutex.lock();
+    if (switchStatePath != "") {
+        // Stopped before the state was loaded again.
+        QFile::remove(switchStatePath);
+        switchStatePath = "";
+    }
+    restoreSwitchState = false;
+    switchMutex.unlock();
+
+    if (scripted) {
+        stopInputScript();
+    }
+    if (netplay) {
+        stopNetplay();
+    }
     if (rval != M64ERR_SUCCESS) {
         SHOW_W(TR("Could not start the ROM: ") + m64errstr(rval));
         CoreDoCommand(M64CMD_ROM_CLOSE, 0, NULL);
@@ -146,6 +229,13 @@ static bool attachPlugin(m64p_plugin_type type,
         SHOW_E(TR("No plugin specified. Go to settings and select plugins."));
         return false;
     }
+    if (name == NullPlugin) {
+        // Leave the slot empty; the core falls back to its dummy plugin.
+        LOG_I(TR("Using the built-in <Name> <Type> plugin.")
+                .replace("<Name>", name).replace("<Type>", typestr));
+        plugin = NULL;
+        return true;
+    }
     m64p_error rval;
     bool ok;
     ok = openPlugin(plugin, name.toUtf8().data(), typestr);
@@ -171,6 +261,7 @@ static bool attachPlugins(QString game)
     if (!attachPlugin(M64PLUGIN_GFX, pluginGfx, name, (char *)"video")) {
         return false;
     }
+    runningVideoPlugin = name;
     name = getCurrentAudioPlugin(game);
     if (!attachPlugin(M64PLUGIN_AUDIO, pluginAudio, name, (char *)"audio")) {
         return false;
@@ -188,33 +279,54 @@ static bool attachPlugins(QString game)
 }
 
 
+static void detachPlugin(m64p_plugin_type type, m64p_dynlib_handle &plugin)
+{
+    if (plugin) {
+        CoreDetachPlugin(type);
+        closePlugin(plugin);
+        plugin = NULL;
+    }
+}
+
+
 static void detachPlugins()
 {
-    if (pluginRsp) {
-        CoreDetachPlugin(M64PLUGIN_RSP);
-        closePlugin(pluginRsp);
-        pluginRsp = NULL;
-    }
-    if (pluginInput) {
-        CoreDetachPlugin(M64PLUGIN_INPUT);
-        closePlugin(pluginInput);
-        pluginInput = NULL;
-    }
-    if (pluginAudio) {
-        CoreDetachPlugin(M64PLUGIN_AUDIO);
-        closePlugin(pluginAudio);
-        pluginAudio = NULL;
-    }
-    if (pluginGfx) {
-        CoreDetachPlugin(M64PLUGIN_GFX);
-        closePlugin(pluginGfx);
-        pluginGfx = NULL;
+    detachPlugin(M64PLUGIN_RSP, pluginRsp);
+    detachPlugin(M64PLUGIN_INPUT, pluginInput);
+    detachPlugin(M64PLUGIN_AUDIO, pluginAudio);
+    detachPlugin(M64PLUGIN_GFX, pluginGfx);
+    runningVideoPlugin = "";
+}
+
+
+// Replaces the video plugin between two runs of EXECUTE, while the ROM is
+// still open. Goes back to the previous plugin if the new one can't be
+// attached.
+static bool switchGfxPlugin(const QString &name)
+{
+    QString previous = runningVideoPlugin;
+    detachPlugin(M64PLUGIN_GFX, pluginGfx);
+    if (attachPlugin(M64PLUGIN_GFX, pluginGfx, name, (char *)"video")) {
+        runningVideoPlugin = name;
+        return true;
+    }
+
+    detachPlugin(M64PLUGIN_GFX, pluginGfx);
+    if (attachPlugin(M64PLUGIN_GFX, pluginGfx, previous, (char *)"video")) {
+        return true;
     }
+    runningVideoPlugin = "";
+    return false;
 }
 
 
 bool Emulation::restartInputPlugin()
 {
+    if (pluginInput == NULL) {
+        // Built-in plugin, nothing to restart.
+        return true;
+    }
+
     m64p_error rval;
     ptr_PluginShutdown pluginShutdown;
     pluginShutdown = (ptr_PluginShutdown)osal_dynlib_getproc(pluginInput,
@@ -238,8 +350,88 @@ bool Emulation::restartInputPlugin()
 }
 
 
-QString Emulation::currentGameFile() const {
-    return currentGameFilename;
+QString Emulation::currentGameMD5() const {
+    return runningGameMD5;
+}
+
+
+QString Emulation::currentVideoPlugin() const
+{
+    return runningVideoPlugin;
+}
+
+
+void Emulation::switchVideoPlugin(const QString &name)
+{
+    if (!isExecuting() || name == runningVideoPlugin) {
+        return;
+    }
+    if (isNetplayEnabled()) {
+        SHOW_W(TR("The video plugin can't be switched during netplay."));
+        return;
+    }
+
+    QMutexLocker locker(&switchMutex);
+    if (requestedVideoPlugin != "" || nextVideoPlugin != "") {
+        return;
+    }
+
+    // States are saved on the next frame, which never comes while paused.
+    play();
+
+    switchTimer.start();
+    // In the user's own data directory, and named after this process so
+    // two running instances don't use the same file.
+    switchStatePath = getDataLocation() + "/switch-"
+                    + QString::number(QCoreApplication::applicationPid()) + ".st";
+    QFile::remove(switchStatePath);
+    requestedVideoPlugin = name;
+    m64p_error rval;
+    rval = CoreDoCommand(M64CMD_STATE_SAVE, 1,
+                         (void *)switchStatePath.toUtf8().constData());
+    if (rval != M64ERR_SUCCESS) {
+        requestedVideoPlugin = "";
+        switchStatePath = "";
+        LOG_W(TR("Could not save state: ") + m64errstr(rval));
+    }
+}
+
+
+void Emulation::coreStateChanged(m64p_core_param param, int value)
+{
+    if (param == M64CORE_EMU_STATE && value == M64EMU_RUNNING && lockPending) {
+        lockPending = false;
+        lockSessionMemory();
+    }
+
+    QMutexLocker locker(&switchMutex);
+
+    if (param == M64CORE_STATE_SAVECOMPLETE && requestedVideoPlugin != "") {
+        if (value) {
+            nextVideoPlugin = requestedVideoPlugin;
+            CoreDoCommand(M64CMD_STOP, 0, NULL);
+        } else {
+            LOG_W(TR("Could not save state, not switching video plugin."));
+            QFile::remove(switchStatePath);
+            switchStatePath = "";
+        }
+        requestedVideoPlugin = "";
+    } else if (param == M64CORE_EMU_STATE && value == M64EMU_RUNNING
+               && restoreSwitchState) {
+        restoreSwitchState = false;
+        CoreDoCommand(M64CMD_STATE_LOAD, 0,
+                      (void *)switchStatePath.toUtf8().constData());
+    } else if (param == M64CORE_STATE_LOADCOMPLETE && switchStatePath != "") {
+        if (value) {
+            LOG_I(TR("Switched to <Name> in <Ms> ms.")
+                  .replace("<Name>", runningVideoPlugin)
+                  .replace("<Ms>", QString::number(switchTimer.elapsed())));
+        } else {
+            SHOW_W(TR("Could not restore the game after switching the video plugin."));
+        }
+        QFile::remove(switchStatePath);
+        switchStatePath = "";
+    }
 }
 
 
@@ -254,6 +446,11 @@ bool Emulation::isExecuting()
 
 void Emulation::stopGame()
 {
+    switchMutex.lock();
+    requestedVideoPlugin = "";
+    nextVideoPlugin = "";
+    switchMutex.unlock();
+
     m64p_error rval;
     rval = CoreDoCommand(M64CMD_STOP, 0, NULL);
     if (rval != M64ERR_SUCCESS) {
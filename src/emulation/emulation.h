@@ -32,9 +32,9 @@
 #ifndef EMULATION_H
 #define EMULATION_H
 
+#include "../cheatparse.h"
 #include <m64p_types.h>
 #include <cstdlib>
-#include <set>
 #include <QObject>
 class QSurfaceFormat;
 class QString;
@@ -52,12 +52,21 @@ public:
     void reset(bool hard);
     bool getRomSettings(size_t size, m64p_rom_settings *romSettings);
     bool restartInputPlugin();
-    QString currentGameFile() const;
+    QString currentGameMD5() const;
+    QString currentVideoPlugin() const;
 
-    static std::set<QString> activeCheats;
+    // Saves the state of the running game, restarts it with another video
+    // plugin and loads the state again, so renderers can be compared on
+    // the same scene. Not possible during netplay.
+    void switchVideoPlugin(const QString &name);
+
+    // Called from the core's state callback in the emulation thread.
+    void coreStateChanged(m64p_core_param param, int value);
+
+    static CheatProfile activeCheats;
 
 signals:
-    void createGlWindow(QSurfaceFormat *format);
+    void createGlWindow(QSurfaceFormat *format, bool fullscreen);
     void destroyGlWindow();
     void resize(int width, int height);
     void started();
@@ -0,0 +1,284 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#include "frametelemetry.h"
+#include "sessionmemory.h"
+#include "../error.h"
+#include "../common.h"
+#include "../global.h"
+
+#include <QElapsedTimer>
+#include <QOpenGLContext>
+#include <QOpenGLDebugLogger>
+#include <QOpenGLTimerQuery>
+
+#define FROM "telemetry"
+
+// Number of frames that can be in flight before a timer query is reused.
+#define QUERY_RING_SIZE 4
+// Print a summary this often.
+#define REPORT_INTERVAL 600
+
+struct FrameStats {
+    int frames;
+    qint64 cpuTotal;
+    qint64 cpuMax;
+    int gpuFrames;
+    qint64 gpuTotal;
+    qint64 gpuMax;
+    int gpuSkipped;
+    long faults;
+    qint64 presentTotal;
+    qint64 presentMax;
+};
+
+static QOpenGLTimerQuery *queries[QUERY_RING_SIZE];
+static int queryCount;      // Queries that have been ended but not read.
+static int queryNext;       // Query to begin for the next frame.
+static bool queryActive;    // A query is between begin and end.
+static bool gpuTiming;
+
+static QOpenGLDebugLogger *debugLogger;
+
+static QElapsedTimer frameTimer;
+static qint64 swapStart;
+static FrameStats stats;
+static QString surfaceName;
+
+
+static double toMs(qint64 ns)
+{
+    return ns / 1000000.0;
+}
+
+
+static void report()
+{
+    if (stats.frames == 0) {
+        return;
+    }
+    QString msg = TR("<N> frames (<Surface>), CPU avg <CpuAvg> ms max <CpuMax> ms, "
+                     "present avg <PresentAvg> ms max <PresentMax> ms")
+        .replace("<N>", QString::number(stats.frames))
+        .replace("<Surface>", surfaceName)
+        .replace("<CpuAvg>", QString::number(toMs(stats.cpuTotal / stats.frames), 'f', 2))
+        .replace("<CpuMax>", QString::number(toMs(stats.cpuMax), 'f', 2))
+        .replace("<PresentAvg>", QString::number(toMs(stats.presentTotal / stats.frames), 'f', 2))
+        .replace("<PresentMax>", QString::number(toMs(stats.presentMax), 'f', 2));
+    if (stats.gpuFrames > 0) {
+        msg += TR(", GPU avg <GpuAvg> ms max <GpuMax> ms (<Skipped> not measured)")
+            .replace("<GpuAvg>", QString::number(toMs(stats.gpuTotal / stats.gpuFrames), 'f', 2))
+            .replace("<GpuMax>", QString::number(toMs(stats.gpuMax), 'f', 2))
+            .replace("<Skipped>", QString::number(stats.gpuSkipped));
+    }
+    long faults = majorFaults();
+    if (faults >= 0) {
+        msg += TR(", <Faults> major page faults")
+            .replace("<Faults>", QString::number(faults - stats.faults));
+    }
+    LOG(L_INFO, FROM, msg);
+    stats = FrameStats();
+    stats.faults = faults;
+}
+
+
+static void readOldestQuery()
+{
+    int oldest = (queryNext - queryCount + QUERY_RING_SIZE) % QUERY_RING_SIZE;
+    qint64 ns = queries[oldest]->waitForResult();
+    stats.gpuFrames++;
+    stats.gpuTotal += ns;
+    stats.gpuMax = qMax(stats.gpuMax, ns);
+    queryCount--;
+}
+
+
+// Reads back all finished queries, oldest first, without waiting.
+static void collectQueries()
+{
+    while (queryCount > 0) {
+        int oldest = (queryNext - queryCount + QUERY_RING_SIZE) % QUERY_RING_SIZE;
+        if (!queries[oldest]->isResultAvailable()) {
+            break;
+        }
+        readOldestQuery();
+    }
+}
+
+
+static void beginQuery()
+{
+    collectQueries();
+    if (queryCount == QUERY_RING_SIZE) {
+        // Every query is still in flight. Skip this frame rather than
+        // waiting for the GPU.
+        stats.gpuSkipped++;
+        return;
+    }
+    queries[queryNext]->begin();
+    queryActive = true;
+}
+
+
+static void endQuery()
+{
+    if (!queryActive) {
+        return;
+    }
+    queries[queryNext]->end();
+    queryActive = false;
+    queryNext = (queryNext + 1) % QUERY_RING_SIZE;
+    queryCount++;
+}
+
+
+static void logDebugMessage(const QOpenGLDebugMessage &message)
+{
+    LogLevel level = L_VERB;
+    if (message.type() == QOpenGLDebugMessage::ErrorType
+            || message.severity() == QOpenGLDebugMessage::HighSeverity) {
+        level = L_ERR;
+    } else if (message.type() == QOpenGLDebugMessage::PerformanceType
+            || message.severity() == QOpenGLDebugMessage::MediumSeverity) {
+        level = L_WARN;
+    } else if (message.severity() == QOpenGLDebugMessage::LowSeverity) {
+        level = L_INFO;
+    }
+    LOG(level, "GL", message.message());
+}
+
+
+static void startDebugLogger(QOpenGLContext *context)
+{
+    if (!context->format().testOption(QSurfaceFormat::DebugContext)) {
+        return;
+    }
+    debugLogger = new QOpenGLDebugLogger;
+    if (!debugLogger->initialize()) {
+        LOG(L_WARN, FROM, TR("KHR_debug is not supported, no GL debug output."));
+        delete debugLogger;
+        debugLogger = NULL;
+        return;
+    }
+    // The logger lives in the emulation thread, which has no event loop,
+    // so messages are delivered directly from the driver callback.
+    QObject::connect(debugLogger, &QOpenGLDebugLogger::messageLogged,
+                     logDebugMessage);
+    debugLogger->startLogging(QOpenGLDebugLogger::SynchronousLogging);
+}
+
+
+void startFrameTelemetry(QOpenGLContext *context, const QString &surface)
+{
+    stats = FrameStats();
+    stats.faults = majorFaults();
+    surfaceName = surface;
+    queryCount = 0;
+    queryNext = 0;
+    queryActive = false;
+    gpuTiming = false;
+
+    startDebugLogger(context);
+
+    if (SETTINGS.value("Graphics/gputiming", "").toString() == "true") {
+        // create() fails unless the context has GL 3.3 or timer queries.
+        gpuTiming = true;
+        for (int i = 0; i < QUERY_RING_SIZE; i++) {
+            queries[i] = new QOpenGLTimerQuery;
+            gpuTiming = gpuTiming && queries[i]->create();
+        }
+        if (!gpuTiming) {
+            LOG(L_WARN, FROM, TR("Timer queries are not supported, no GPU timing."));
+        }
+    }
+
+    frameTimer.start();
+    if (gpuTiming) {
+        beginQuery();
+    }
+}
+
+
+void frameTelemetryBeforeSwap()
+{
+    qint64 ns = frameTimer.nsecsElapsed();
+    stats.frames++;
+    stats.cpuTotal += ns;
+    stats.cpuMax = qMax(stats.cpuMax, ns);
+
+    if (gpuTiming) {
+        endQuery();
+    }
+    swapStart = frameTimer.nsecsElapsed();
+}
+
+
+void frameTelemetryAfterSwap()
+{
+    qint64 ns = frameTimer.nsecsElapsed() - swapStart;
+    stats.presentTotal += ns;
+    stats.presentMax = qMax(stats.presentMax, ns);
+
+    if (stats.frames >= REPORT_INTERVAL) {
+        report();
+    }
+    frameTimer.restart();
+    if (gpuTiming) {
+        beginQuery();
+    }
+}
+
+
+void stopFrameTelemetry()
+{
+    if (gpuTiming) {
+        endQuery();
+        // The context is about to go away, so this is the one place
+        // where it is fine to wait for the GPU.
+        while (queryCount > 0) {
+            readOldestQuery();
+        }
+    }
+    report();
+
+    for (int i = 0; i < QUERY_RING_SIZE; i++) {
+        delete queries[i];
+        queries[i] = NULL;
+    }
+    gpuTiming = false;
+
+    if (debugLogger) {
+        debugLogger->stopLogging();
+        delete debugLogger;
+        debugLogger = NULL;
+    }
+}
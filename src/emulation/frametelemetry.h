@@ -0,0 +1,63 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#ifndef FRAMETELEMETRY_H
+#define FRAMETELEMETRY_H
+
+class QOpenGLContext;
+class QString;
+
+// Frame timing for the game window. CPU time is measured between buffer
+// swaps and, when Graphics/gputiming is enabled and the driver has
+// GL_ARB_timer_query, GPU time is measured for the same frames. Timer
+// queries are kept in a small ring and only read back once their result
+// is available, so measuring never stalls the pipeline. When
+// Graphics/gldebug is enabled, KHR_debug messages are written to the log.
+//
+// The time spent in each buffer swap is reported as present time. It is
+// where the compositor or the display makes the game wait, so comparing
+// it between windowed, fullscreen and compositor bypassed surfaces shows
+// what each costs. The surface is named in every report for that reason.
+// Each report also counts the major page faults since the last one.
+//
+// All functions are called from the emulation thread with the game's
+// context current.
+
+void startFrameTelemetry(QOpenGLContext *context, const QString &surface);
+
+// Called right before and right after each buffer swap.
+void frameTelemetryBeforeSwap();
+void frameTelemetryAfterSwap();
+
+void stopFrameTelemetry();
+
+#endif // FRAMETELEMETRY_H
@@ -31,9 +31,20 @@
 
 #include "glwindow.h"
 #include "emulation.h"
+#include "../common.h"
+#include "../global.h"
 #include "../sdl.h"
 #include <QKeyEvent>
 
+#ifdef Q_OS_LINUX
+#include <QX11Info>
+#include <xcb/xcb.h>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+static bool compositorBypassed = false;
+
 void GlWindow::initializeGL()
 {
     extern EmuThread *emuthread;
@@ -54,3 +65,44 @@ void GlWindow::keyReleaseEvent(QKeyEvent *keyEvent)
     extern Emulation emulation;
     emulation.sendKeyUp(qtToSdlScancode(keyEvent));
 }
+
+
+void setCompositorBypass(QWindow *window, bool bypass)
+{
+    if (bypass && SETTINGS.value("Graphics/bypasscompositor", "true").toString() != "true")
+        return;
+    if (bypass == compositorBypassed)
+        return;
+
+#ifdef Q_OS_LINUX
+    if (!window || !QX11Info::isPlatformX11())
+        return;
+
+    xcb_connection_t *connection = QX11Info::connection();
+    const char *name = "_NET_WM_BYPASS_COMPOSITOR";
+    xcb_intern_atom_cookie_t cookie = xcb_intern_atom(connection, 0, strlen(name), name);
+    xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(connection, cookie, NULL);
+    if (!reply)
+        return;
+
+    if (bypass) {
+        uint32_t value = 1;
+        xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window->winId(),
+                            reply->atom, XCB_ATOM_CARDINAL, 32, 1, &value);
+    } else {
+        xcb_delete_property(connection, window->winId(), reply->atom);
+    }
+    free(reply);
+    xcb_flush(connection);
+
+    compositorBypassed = bypass;
+#else
+    Q_UNUSED(window);
+#endif
+}
+
+
+bool isCompositorBypassed()
+{
+    return compositorBypassed;
+}
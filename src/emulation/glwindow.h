@@ -47,4 +47,12 @@ public:
 };
 
 
+// Asks the window manager to stop compositing the top-level window while
+// it is fullscreen, which removes a frame of latency. Only X11 has a way
+// to ask for this (_NET_WM_BYPASS_COMPOSITOR), elsewhere it does nothing.
+// Controlled by Graphics/bypasscompositor, which is on by default.
+void setCompositorBypass(QWindow *window, bool bypass);
+bool isCompositorBypassed();
+
+
 #endif // GLWINDOW_H
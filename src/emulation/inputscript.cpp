@@ -0,0 +1,265 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#include "inputscript.h"
+#include "../core.h"
+#include "../error.h"
+#include "../common.h"
+#include "../osal/osal_dynamiclib.h"
+
+#include <SDL.h>
+#include <QFile>
+#include <QRegExp>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#define FROM "input-script"
+
+#define STICK_MAX 80
+
+enum ScriptAction {
+    A_KEY_DOWN, A_KEY_UP, A_PRESS, A_RELEASE, A_STICK, A_STOP,
+};
+
+struct ScriptEvent {
+    unsigned int frame;
+    ScriptAction action;
+    int key;            // SDL scancode, or button mask for press and release
+    int controller;     // 0-3
+    int x, y;
+};
+
+struct ButtonName {
+    const char *name;
+    unsigned int mask;
+};
+
+// Bits of the BUTTONS value in m64p_plugin.h.
+static const ButtonName buttonNames[] = {
+    {"DRight", 0x0001}, {"DLeft", 0x0002}, {"DDown", 0x0004}, {"DUp", 0x0008},
+    {"Start", 0x0010}, {"Z", 0x0020}, {"B", 0x0040}, {"A", 0x0080},
+    {"CRight", 0x0100}, {"CLeft", 0x0200}, {"CDown", 0x0400}, {"CUp", 0x0800},
+    {"R", 0x1000}, {"L", 0x2000},
+};
+
+typedef void (*ptr_ScriptSetPresent)(int, int);
+typedef void (*ptr_ScriptSetButtons)(int, unsigned int);
+
+// Sorted by frame. Only touched from the emulation thread while a game
+// is running.
+static std::vector<ScriptEvent> events;
+static size_t nextEvent;
+static unsigned int controllerState[4];
+static ptr_ScriptSetButtons setButtons;
+
+
+static unsigned int buttonMask(const QString &name)
+{
+    for (const ButtonName &button : buttonNames) {
+        if (name.compare(button.name, Qt::CaseInsensitive) == 0) {
+            return button.mask;
+        }
+    }
+    return 0;
+}
+
+
+// Parses an optional controller number, which is the last word if the
+// line has more than count words.
+static bool parseController(const QStringList &words, int count, int *controller)
+{
+    *controller = 0;
+    if (words.size() == count) {
+        return true;
+    }
+    if (words.size() != count + 1) {
+        return false;
+    }
+    bool ok;
+    *controller = words[count].toInt(&ok) - 1;
+    return ok && *controller >= 0 && *controller < 4;
+}
+
+
+static void frameCallback(unsigned int frameIndex)
+{
+    while (nextEvent < events.size() && events[nextEvent].frame <= frameIndex) {
+        const ScriptEvent &e = events[nextEvent];
+        switch (e.action) {
+        case A_KEY_DOWN:
+            CoreDoCommand(M64CMD_SEND_SDL_KEYDOWN, e.key, NULL);
+            break;
+        case A_KEY_UP:
+            CoreDoCommand(M64CMD_SEND_SDL_KEYUP, e.key, NULL);
+            break;
+        case A_PRESS:
+            controllerState[e.controller] |= e.key;
+            break;
+        case A_RELEASE:
+            controllerState[e.controller] &= ~e.key;
+            break;
+        case A_STICK:
+            controllerState[e.controller] = (controllerState[e.controller] & 0xffff)
+                | ((e.x & 0xff) << 16) | ((e.y & 0xff) << 24);
+            break;
+        case A_STOP:
+            LOG(L_INFO, FROM, TR("Stopping at frame <N>.")
+                    .replace("<N>", QString::number(frameIndex)));
+            CoreDoCommand(M64CMD_STOP, 0, NULL);
+            break;
+        }
+        if (setButtons && (e.action == A_PRESS || e.action == A_RELEASE
+                           || e.action == A_STICK)) {
+            setButtons(e.controller, controllerState[e.controller]);
+        }
+        nextEvent++;
+    }
+}
+
+
+bool loadInputScript(const QString &fileName)
+{
+    events.clear();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        LOG(L_WARN, FROM, TR("Could not open input script <File>.")
+                .replace("<File>", fileName));
+        return false;
+    }
+
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        lineNumber++;
+        if (line == "" || line.startsWith("#")) {
+            continue;
+        }
+
+        QStringList words = line.split(QRegExp("\\s+"));
+        ScriptEvent e;
+        bool ok;
+        e.frame = words.value(0).toUInt(&ok);
+        e.key = SDL_SCANCODE_UNKNOWN;
+        e.controller = 0;
+        e.x = e.y = 0;
+        QString action = words.value(1);
+
+        if (ok && action == "stop" && words.size() == 2) {
+            e.action = A_STOP;
+        } else if (ok && (action == "press" || action == "release")) {
+            e.action = action == "press" ? A_PRESS : A_RELEASE;
+            e.key = buttonMask(words.value(2));
+            ok = e.key != 0 && parseController(words, 3, &e.controller);
+        } else if (ok && action == "stick") {
+            e.action = A_STICK;
+            bool okX, okY;
+            e.x = words.value(2).toInt(&okX);
+            e.y = words.value(3).toInt(&okY);
+            ok = okX && okY && qAbs(e.x) <= STICK_MAX && qAbs(e.y) <= STICK_MAX
+                && parseController(words, 4, &e.controller);
+        } else if (ok && (action == "down" || action == "up")
+                && words.size() == 3) {
+            e.action = action == "down" ? A_KEY_DOWN : A_KEY_UP;
+            e.key = SDL_GetScancodeFromName(words[2].toUtf8().data());
+            ok = e.key != SDL_SCANCODE_UNKNOWN;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            LOG(L_WARN, FROM, TR("Invalid line <N> in input script: ")
+                    .replace("<N>", QString::number(lineNumber)) + line);
+            events.clear();
+            return false;
+        }
+        events.push_back(e);
+    }
+
+    std::stable_sort(events.begin(), events.end(),
+            [](const ScriptEvent &a, const ScriptEvent &b) {
+                return a.frame < b.frame;
+            });
+    return true;
+}
+
+
+void startInputScript(m64p_dynlib_handle inputPlugin)
+{
+    nextEvent = 0;
+    memset(controllerState, 0, sizeof controllerState);
+
+    bool usesController[4] = {false, false, false, false};
+    bool hasControllerInput = false;
+    for (const ScriptEvent &e : events) {
+        if (e.action == A_PRESS || e.action == A_RELEASE || e.action == A_STICK) {
+            usesController[e.controller] = true;
+            hasControllerInput = true;
+        }
+    }
+
+    setButtons = NULL;
+    ptr_ScriptSetPresent setPresent = NULL;
+    if (inputPlugin) {
+        setButtons = (ptr_ScriptSetButtons)osal_dynlib_getproc(inputPlugin, "ScriptSetButtons");
+        setPresent = (ptr_ScriptSetPresent)osal_dynlib_getproc(inputPlugin, "ScriptSetPresent");
+    }
+    if (setButtons && setPresent) {
+        for (int i = 0; i < 4; i++) {
+            setPresent(i, usesController[i] || (i == 0 && !hasControllerInput));
+            setButtons(i, 0);
+        }
+    } else if (hasControllerInput) {
+        setButtons = NULL;
+        LOG(L_WARN, FROM, TR("Controller input in the script needs the script input plugin."));
+    }
+
+    m64p_error rval;
+    rval = CoreDoCommand(M64CMD_SET_FRAME_CALLBACK, 0, (void *)frameCallback);
+    if (rval != M64ERR_SUCCESS) {
+        LOG(L_WARN, FROM, TR("Could not set frame callback: ")
+                + m64errstr(rval));
+    }
+}
+
+
+void stopInputScript()
+{
+    CoreDoCommand(M64CMD_SET_FRAME_CALLBACK, 0, NULL);
+    events.clear();
+    setButtons = NULL;
+}
@@ -0,0 +1,68 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#ifndef INPUTSCRIPT_H
+#define INPUTSCRIPT_H
+
+#include <m64p_types.h>
+
+class QString;
+
+// An input script lists input for the game at given frames, one event
+// per line. Lines starting with # are comments.
+//
+//   <frame> press <button> [<controller>]
+//   <frame> release <button> [<controller>]
+//   <frame> stick <x> <y> [<controller>]
+//   <frame> down <key>
+//   <frame> up <key>
+//   <frame> stop
+//
+// Buttons are A, B, Z, L, R, Start, DUp, DDown, DLeft, DRight, CUp,
+// CDown, CLeft and CRight, the stick goes from -80 to 80 and controllers
+// are numbered from 1, which is the default. Controller input takes
+// effect on the frame after the one given and needs the script input
+// plugin, which plugs in the controllers the script uses. Keys are SDL
+// scancode names like "X" or "Return" and go to the attached input plugin
+// the same way as keys pressed in the game window, which also reaches the
+// core's hotkeys.
+
+bool loadInputScript(const QString &fileName);
+
+// Registers the frame callback that plays the loaded script. Call after
+// the ROM is opened and the input plugin is attached, before the game is
+// executed.
+void startInputScript(m64p_dynlib_handle inputPlugin);
+
+void stopInputScript();
+
+#endif // INPUTSCRIPT_H
@@ -0,0 +1,235 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+
+#include "netplay.h"
+#include "../core.h"
+#include "../error.h"
+#include "../common.h"
+
+#include <cstring>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QTimer>
+#include <QUdpSocket>
+
+#define FROM "netplay"
+
+// Netplay API version this frontend was written for.
+#define NETPLAY_API_VERSION 0x010001
+
+#define PING_INTERVAL 500
+// Number of pings the average round trip is taken over.
+#define PING_WINDOW 20
+
+
+bool isNetplayEnabled()
+{
+    return SETTINGS.value("Netplay/enabled", "").toString() == "true";
+}
+
+
+bool startNetplay()
+{
+    QString host = SETTINGS.value("Netplay/host", "127.0.0.1").toString();
+    int port = SETTINGS.value("Netplay/port", NETPLAY_DEFAULT_PORT).toInt();
+    int player = SETTINGS.value("Netplay/player", 1).toInt();
+
+    m64p_error rval;
+    quint32 version;
+    rval = CoreDoCommand(M64CMD_NETPLAY_GET_VERSION, NETPLAY_API_VERSION, &version);
+    if (rval != M64ERR_SUCCESS) {
+        SHOW_W(TR("The core does not support netplay: ") + m64errstr(rval));
+        return false;
+    }
+
+    rval = CoreDoCommand(M64CMD_NETPLAY_INIT, port, host.toUtf8().data());
+    if (rval != M64ERR_SUCCESS) {
+        SHOW_W(TR("Could not connect to the netplay server <Host>: ")
+                .replace("<Host>", host + ":" + QString::number(port))
+                + m64errstr(rval));
+        return false;
+    }
+
+    // The server tells players apart by this ID, so two instances on the
+    // same machine must not pick the same one.
+    quint32 regId = QDateTime::currentMSecsSinceEpoch()
+                  ^ (QCoreApplication::applicationPid() << 16);
+    if (regId == 0) {
+        regId = 1;
+    }
+
+    rval = CoreDoCommand(M64CMD_NETPLAY_CONTROL_PLAYER, player, &regId);
+    if (rval != M64ERR_SUCCESS) {
+        SHOW_W(TR("Could not join the netplay game as player <N>: ")
+                .replace("<N>", QString::number(player)) + m64errstr(rval));
+        CoreDoCommand(M64CMD_NETPLAY_CLOSE, 0, NULL);
+        return false;
+    }
+
+    LOG(L_INFO, FROM, TR("Playing as player <N> on <Host>.")
+            .replace("<N>", QString::number(player))
+            .replace("<Host>", host + ":" + QString::number(port)));
+    return true;
+}
+
+
+void stopNetplay()
+{
+    CoreDoCommand(M64CMD_NETPLAY_CLOSE, 0, NULL);
+}
+
+
+NetplayMonitor::NetplayMonitor(QObject *parent)
+    : QObject(parent)
+{
+    socket = new QUdpSocket(this);
+    timer = new QTimer(this);
+    timer->setInterval(PING_INTERVAL);
+
+    connect(socket, SIGNAL(readyRead()), this, SLOT(readReplies()));
+    connect(timer, SIGNAL(timeout()), this, SLOT(sendPing()));
+}
+
+
+void NetplayMonitor::start(const QString &host, int port)
+{
+    stop();
+
+    memset(&stats, 0, sizeof stats);
+    stats.lastRoundTrip = -1;
+    stats.minRoundTrip = -1;
+    stats.averageRoundTrip = -1;
+    stats.maxRoundTrip = -1;
+    sentPings = 0;
+    answeredPings = 0;
+    roundTrips.clear();
+
+    clock.start();
+    socket->connectToHost(host, port);
+    timer->start();
+}
+
+
+bool NetplayMonitor::isRunning() const
+{
+    return timer->isActive();
+}
+
+
+void NetplayMonitor::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+    timer->stop();
+    socket->abort();
+
+    if (stats.lastRoundTrip >= 0) {
+        LOG(L_INFO, FROM, TR("Round trip <Min>/<Avg>/<Max> ms, <Lost> of <Sent> pings lost.")
+                .replace("<Min>", QString::number(stats.minRoundTrip))
+                .replace("<Avg>", QString::number(stats.averageRoundTrip))
+                .replace("<Max>", QString::number(stats.maxRoundTrip))
+                .replace("<Lost>", QString::number(stats.lostPings))
+                .replace("<Sent>", QString::number(sentPings)));
+    }
+}
+
+
+void NetplayMonitor::sendPing()
+{
+    if (socket->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+
+    // Replies to earlier pings that never came are lost.
+    stats.lostPings = qMax(0, int(sentPings - answeredPings) - 1);
+
+    QByteArray packet;
+    QDataStream out(&packet, QIODevice::WriteOnly);
+    out << quint8(NETPLAY_PING) << sentPings << quint32(clock.elapsed());
+    socket->write(packet);
+    sentPings++;
+}
+
+
+void NetplayMonitor::readReplies()
+{
+    while (socket->hasPendingDatagrams()) {
+        QByteArray packet(socket->pendingDatagramSize(), 0);
+        socket->readDatagram(packet.data(), packet.size());
+
+        QDataStream in(packet);
+        quint8 type, status, inputDelay;
+        quint32 sequence, sent;
+        in >> type >> sequence >> sent >> status >> inputDelay;
+        if (in.status() != QDataStream::Ok || type != NETPLAY_PING_REPLY) {
+            continue;
+        }
+
+        for (int i = 0; i < 4; i++) {
+            quint8 registered, bufferHealth, lag;
+            in >> registered >> bufferHealth >> lag >> stats.players[i].stalls;
+            stats.players[i].registered = registered;
+            stats.players[i].bufferHealth = bufferHealth;
+            stats.players[i].lag = lag;
+        }
+        if (in.status() != QDataStream::Ok) {
+            continue;
+        }
+        stats.fromServer = true;
+        stats.desync = status & 1;
+        stats.inputDelay = inputDelay;
+
+        int roundTrip = clock.elapsed() - sent;
+        answeredPings++;
+
+        roundTrips.append(roundTrip);
+        if (roundTrips.size() > PING_WINDOW) {
+            roundTrips.remove(0);
+        }
+        int sum = 0;
+        foreach (int r, roundTrips) {
+            sum += r;
+        }
+
+        stats.lastRoundTrip = roundTrip;
+        stats.averageRoundTrip = sum / roundTrips.size();
+        if (stats.minRoundTrip < 0 || roundTrip < stats.minRoundTrip) {
+            stats.minRoundTrip = roundTrip;
+        }
+        stats.maxRoundTrip = qMax(stats.maxRoundTrip, roundTrip);
+
+        emit updated(stats);
+    }
+}
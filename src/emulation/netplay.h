@@ -0,0 +1,122 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+
+#ifndef NETPLAY_H
+#define NETPLAY_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QVector>
+
+class QTimer;
+class QUdpSocket;
+
+#define NETPLAY_DEFAULT_PORT 45000
+
+// Netplay itself runs inside the core. The frontend only tells the core
+// which server to use and which controller this instance plays, between
+// opening and executing the ROM. The settings are in the Netplay group.
+
+bool isNetplayEnabled();
+
+// Connects the core to the netplay server and registers the player.
+// Shows a warning and returns false if that fails.
+bool startNetplay();
+
+void stopNetplay();
+
+
+// Not part of the core's protocol: a ping that the built-in test server
+// answers with its statistics. Other servers ignore it.
+#define NETPLAY_PING       0xf0
+#define NETPLAY_PING_REPLY 0xf1
+
+struct NetplayPlayerStats {
+    bool registered;
+    // Frames of input the player's client had buffered when it last
+    // asked for input.
+    int bufferHealth;
+    // Frames the player is behind the fastest client.
+    int lag;
+    // Requests for the player's input that the server could not answer.
+    quint32 stalls;
+};
+
+struct NetplayStats {
+    // Ping round trip in milliseconds, -1 until the first reply.
+    int lastRoundTrip;
+    int minRoundTrip;
+    int averageRoundTrip;
+    int maxRoundTrip;
+    int lostPings;
+
+    // The rest is only filled in by the test server.
+    bool fromServer;
+    bool desync;
+    int inputDelay;
+    NetplayPlayerStats players[4];
+};
+
+// Pings the netplay server from the UI thread while a game runs.
+class NetplayMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NetplayMonitor(QObject *parent = 0);
+
+    void start(const QString &host, int port);
+    bool isRunning() const;
+
+public slots:
+    void stop();
+
+signals:
+    void updated(const NetplayStats &stats);
+
+private slots:
+    void sendPing();
+    void readReplies();
+
+private:
+    QUdpSocket *socket;
+    QTimer *timer;
+    QElapsedTimer clock;
+    quint32 sentPings;
+    quint32 answeredPings;
+    // Round trips of the last few pings
+    QVector<int> roundTrips;
+    NetplayStats stats;
+};
+
+#endif // NETPLAY_H
@@ -0,0 +1,594 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+
+#include "netplayserver.h"
+#include "netplay.h"
+#include "../error.h"
+#include "../common.h"
+
+#include <QDataStream>
+#include <QSet>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QtEndian>
+
+#define FROM "netplay-server"
+
+// Packet types of the core's netplay protocol
+#define UDP_SEND_KEY_INFO               0
+#define UDP_RECEIVE_KEY_INFO            1
+#define UDP_REQUEST_KEY_INFO            2
+#define UDP_RECEIVE_KEY_INFO_GRATUITOUS 3
+#define UDP_SYNC_DATA                   4
+
+#define TCP_SEND_SAVE         1
+#define TCP_RECEIVE_SAVE      2
+#define TCP_SEND_SETTINGS     3
+#define TCP_RECEIVE_SETTINGS  4
+#define TCP_REGISTER_PLAYER   5
+#define TCP_GET_REGISTRATION  6
+#define TCP_DISCONNECT_NOTICE 7
+
+#define SETTINGS_SIZE  24
+// The CP0 registers the clients send to detect desyncs
+#define SYNC_DATA_SIZE 128
+#define STATUS_DESYNC  1
+#define MAX_UDP_PAYLOAD 508
+#define MAX_SAVE_SIZE (16 * 1024 * 1024)
+
+// Frames of input and sync data kept for clients that are behind.
+#define HISTORY 3600
+
+// How long to wait for all players before starting with those who came.
+#define REGISTRATION_TIMEOUT 30000
+
+// Whether frame count a comes before b, allowing for wrap-around.
+static bool countBefore(quint32 a, quint32 b)
+{
+    return a - b >= 0x80000000u;
+}
+
+
+NetplayServer::NetplayServer(QObject *parent)
+    : QObject(parent)
+    , latency(0)
+    , jitter(0)
+    , inputDelay(2)
+    , bufferSize(2)
+    , playerCount(2)
+{
+    tcpServer = new QTcpServer(this);
+    udpSocket = new QUdpSocket(this);
+    registrationTimer = new QTimer(this);
+    registrationTimer->setSingleShot(true);
+    registrationTimer->setInterval(REGISTRATION_TIMEOUT);
+
+    connect(tcpServer, SIGNAL(newConnection()), this, SLOT(acceptConnection()));
+    connect(udpSocket, SIGNAL(readyRead()), this, SLOT(readUdp()));
+    connect(registrationTimer, SIGNAL(timeout()), this, SLOT(closeRegistration()));
+
+    reset();
+}
+
+
+NetplayServer::~NetplayServer()
+{
+    close();
+}
+
+
+bool NetplayServer::listen(quint16 port)
+{
+    close();
+
+    if (!tcpServer->listen(QHostAddress::Any, port)
+            || !udpSocket->bind(QHostAddress::Any, port)) {
+        LOG(L_WARN, FROM, TR("Could not listen on port <Port>.")
+                .replace("<Port>", QString::number(port)));
+        close();
+        return false;
+    }
+
+    LOG(L_INFO, FROM, TR("Listening on port <Port>.")
+            .replace("<Port>", QString::number(port)));
+    return true;
+}
+
+
+void NetplayServer::close()
+{
+    registrationTimer->stop();
+
+    QList<QTcpSocket *> sockets = tcpBuffers.keys();
+    tcpBuffers.clear();
+    foreach (QTcpSocket *socket, sockets) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+
+    tcpServer->close();
+    udpSocket->close();
+    reset();
+}
+
+
+bool NetplayServer::isListening() const
+{
+    return tcpServer->isListening();
+}
+
+
+void NetplayServer::setLatency(int latency, int jitter)
+{
+    this->latency = qMax(latency, 0);
+    this->jitter = qMax(jitter, 0);
+}
+
+
+void NetplayServer::setInputDelay(int frames)
+{
+    inputDelay = qBound(0, frames, 255);
+}
+
+
+void NetplayServer::setBufferSize(int frames)
+{
+    bufferSize = qBound(0, frames, 255);
+}
+
+
+void NetplayServer::setPlayerCount(int count)
+{
+    playerCount = qBound(1, count, 4);
+}
+
+
+void NetplayServer::reset()
+{
+    for (int i = 0; i < 4; i++) {
+        Player &p = players[i];
+        p.regId = 0;
+        p.plugin = 0;
+        p.raw = 0;
+        p.address = QHostAddress();
+        p.port = 0;
+        p.inputs.clear();
+        p.pending.keys = 0;
+        p.pending.plugin = 0;
+        p.bufferHealth = 0;
+        p.lag = 0;
+        p.stalls = 0;
+    }
+    registrationClosed = false;
+    status = 0;
+    leadCount = 0;
+    settings.clear();
+    saves.clear();
+    syncValues.clear();
+}
+
+
+int NetplayServer::packetDelay() const
+{
+    if (jitter == 0) {
+        return latency;
+    }
+    return latency + qrand() % (jitter + 1);
+}
+
+
+void NetplayServer::sendUdp(const QByteArray &packet,
+        const QHostAddress &address, quint16 port)
+{
+    int delay = packetDelay();
+    if (delay == 0) {
+        udpSocket->writeDatagram(packet, address, port);
+        return;
+    }
+    QTimer::singleShot(delay, this, [=]() {
+        udpSocket->writeDatagram(packet, address, port);
+    });
+}
+
+
+void NetplayServer::readUdp()
+{
+    while (udpSocket->hasPendingDatagrams()) {
+        QByteArray packet(udpSocket->pendingDatagramSize(), 0);
+        QHostAddress address;
+        quint16 port;
+        udpSocket->readDatagram(packet.data(), packet.size(), &address, &port);
+
+        int delay = packetDelay();
+        if (delay == 0) {
+            processUdp(packet, address, port);
+        } else {
+            QTimer::singleShot(delay, this, [=]() {
+                processUdp(packet, address, port);
+            });
+        }
+    }
+}
+
+
+void NetplayServer::processUdp(const QByteArray &packet,
+        const QHostAddress &address, quint16 port)
+{
+    const uchar *data = (const uchar *)packet.constData();
+    int size = packet.size();
+    if (size == 0) {
+        return;
+    }
+
+    switch (data[0]) {
+    case UDP_SEND_KEY_INFO: {
+        quint8 player = size >= 11 ? data[1] : 4;
+        if (player >= 4) {
+            return;
+        }
+        quint32 count = qFromBigEndian<quint32>(data + 2);
+        players[player].pending.keys = qFromBigEndian<quint32>(data + 6);
+        players[player].pending.plugin = data[10];
+
+        // Pass on the input right away instead of waiting to be asked.
+        for (int i = 0; i < 4; i++) {
+            if (!players[i].address.isNull()) {
+                sendUdp(inputPacket(UDP_RECEIVE_KEY_INFO_GRATUITOUS, player, count, true),
+                        players[i].address, players[i].port);
+            }
+        }
+        break;
+    }
+    case UDP_REQUEST_KEY_INFO: {
+        quint8 player = size >= 12 ? data[1] : 4;
+        if (player >= 4) {
+            return;
+        }
+        quint32 regId = qFromBigEndian<quint32>(data + 2);
+        quint32 count = qFromBigEndian<quint32>(data + 6);
+        bool spectator = data[10];
+
+        int requester = -1;
+        for (int i = 0; i < 4; i++) {
+            if (regId != 0 && players[i].regId == regId) {
+                players[i].address = address;
+                players[i].port = port;
+                requester = i;
+            }
+        }
+
+        if (!spectator) {
+            if (!countBefore(count, leadCount)) {
+                leadCount = count;
+            }
+            players[player].bufferHealth = data[11];
+        }
+
+        QByteArray reply = inputPacket(UDP_RECEIVE_KEY_INFO, player, count, spectator);
+        if (!spectator && reply[4] == 0) {
+            players[player].stalls++;
+        }
+        if (requester >= 0) {
+            players[requester].lag = reply[3];
+        }
+        sendUdp(reply, address, port);
+        break;
+    }
+    case UDP_SYNC_DATA: {
+        if (size < 5 + SYNC_DATA_SIZE || (status & STATUS_DESYNC)) {
+            return;
+        }
+        quint32 viCount = qFromBigEndian<quint32>(data + 1);
+        QByteArray value = packet.mid(5, SYNC_DATA_SIZE);
+
+        if (!syncValues.contains(viCount)) {
+            syncValues.insert(viCount, value);
+            while (syncValues.size() > HISTORY) {
+                syncValues.erase(syncValues.begin());
+            }
+        } else if (syncValues.value(viCount) != value) {
+            status |= STATUS_DESYNC;
+            LOG(L_WARN, FROM, TR("Players desynced at VI <N>.")
+                    .replace("<N>", QString::number(viCount)));
+        }
+        break;
+    }
+    case NETPLAY_PING:
+        sendUdp(pingReply(packet), address, port);
+        break;
+    }
+}
+
+
+// Builds a packet with the player's inputs from the given frame on.
+// Inputs the player has not sent yet are filled in with its latest input
+// for up to inputDelay frames ahead of the fastest client, which is what
+// gives the players time to receive each other's inputs.
+QByteArray NetplayServer::inputPacket(quint8 type, quint8 player,
+        quint32 count, bool spectator)
+{
+    Player &p = players[player];
+
+    quint32 countLag = leadCount - count;
+    if (countBefore(leadCount, count)) {
+        countLag = 0;
+    }
+
+    QByteArray packet;
+    packet.append(char(type));
+    packet.append(char(player));
+    packet.append(char(status));
+    packet.append(char(qMin(countLag, 255u)));
+    packet.append(char(0));
+
+    quint32 end = count + inputDelay;
+    quint8 entries = 0;
+
+    while (packet.size() + 9 <= MAX_UDP_PAYLOAD) {
+        Input input;
+        if (p.inputs.contains(count)) {
+            input = p.inputs.value(count);
+        } else if (!spectator && countLag == 0 && countBefore(count, end)) {
+            input = p.pending;
+            p.inputs.insert(count, input);
+            while (p.inputs.size() > HISTORY) {
+                p.inputs.erase(p.inputs.begin());
+            }
+        } else {
+            break;
+        }
+
+        uchar entry[9];
+        qToBigEndian(count, entry);
+        qToBigEndian(input.keys, entry + 4);
+        entry[8] = input.plugin;
+        packet.append((const char *)entry, sizeof entry);
+
+        count++;
+        entries++;
+    }
+
+    packet[4] = char(entries);
+    return packet;
+}
+
+
+QByteArray NetplayServer::pingReply(const QByteArray &ping) const
+{
+    QDataStream in(ping);
+    quint8 type;
+    quint32 sequence, sent;
+    in >> type >> sequence >> sent;
+
+    QByteArray reply;
+    QDataStream out(&reply, QIODevice::WriteOnly);
+    out << quint8(NETPLAY_PING_REPLY) << sequence << sent
+        << status << quint8(inputDelay);
+    for (int i = 0; i < 4; i++) {
+        out << quint8(players[i].regId != 0) << players[i].bufferHealth
+            << players[i].lag << players[i].stalls;
+    }
+    return reply;
+}
+
+
+void NetplayServer::acceptConnection()
+{
+    while (tcpServer->hasPendingConnections()) {
+        QTcpSocket *socket = tcpServer->nextPendingConnection();
+        tcpBuffers.insert(socket, QByteArray());
+
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readTcp()));
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            tcpBuffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+
+void NetplayServer::readTcp()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket || !tcpBuffers.contains(socket)) {
+        return;
+    }
+    tcpBuffers[socket].append(socket->readAll());
+    processTcp();
+}
+
+
+void NetplayServer::closeRegistration()
+{
+    registrationClosed = true;
+    processTcp();
+}
+
+
+// Answers the requests of all clients. Some requests wait for another
+// client, e.g. player 2 asking for the save that player 1 has not sent
+// yet, so keep going as long as any request was answered.
+void NetplayServer::processTcp()
+{
+    // A broken request stays in the buffer, so it is seen on every pass.
+    QSet<QTcpSocket *> broken;
+    bool progress = true;
+
+    while (progress) {
+        progress = false;
+        for (auto it = tcpBuffers.begin(); it != tcpBuffers.end(); ++it) {
+            QByteArray &buffer = it.value();
+            while (!buffer.isEmpty()) {
+                if (!processRequest(it.key(), buffer)) {
+                    break;
+                }
+                progress = true;
+            }
+            if (buffer.startsWith(char(0xff))) {
+                broken.insert(it.key());
+            }
+        }
+    }
+
+    foreach (QTcpSocket *socket, broken) {
+        LOG(L_WARN, FROM, TR("Closing connection after an invalid request."));
+        tcpBuffers.remove(socket);
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+}
+
+
+// Answers the request at the start of the buffer and removes it. Returns
+// false if the request is not complete or has to wait. An invalid
+// request is replaced by a single 0xff byte.
+bool NetplayServer::processRequest(QTcpSocket *socket, QByteArray &buffer)
+{
+    const uchar *data = (const uchar *)buffer.constData();
+    int size = buffer.size();
+
+    switch (data[0]) {
+    case TCP_SEND_SAVE: {
+        int nameEnd = buffer.indexOf('\0', 1);
+        if (nameEnd < 0 || size < nameEnd + 5) {
+            return false;
+        }
+        quint32 length = qFromBigEndian<quint32>(data + nameEnd + 1);
+        if (length > MAX_SAVE_SIZE) {
+            break;
+        }
+        if (size < nameEnd + 5 + int(length)) {
+            return false;
+        }
+        QString name = QString::fromUtf8(buffer.mid(1, nameEnd - 1));
+        saves.insert(name, buffer.mid(nameEnd + 5, length));
+        buffer.remove(0, nameEnd + 5 + length);
+        return true;
+    }
+    case TCP_RECEIVE_SAVE: {
+        int nameEnd = buffer.indexOf('\0', 1);
+        if (nameEnd < 0) {
+            return false;
+        }
+        QString name = QString::fromUtf8(buffer.mid(1, nameEnd - 1));
+        if (!saves.contains(name)) {
+            return false;
+        }
+        socket->write(saves.value(name));
+        buffer.remove(0, nameEnd + 1);
+        return true;
+    }
+    case TCP_SEND_SETTINGS:
+        if (size < 1 + SETTINGS_SIZE) {
+            return false;
+        }
+        settings = buffer.mid(1, SETTINGS_SIZE);
+        buffer.remove(0, 1 + SETTINGS_SIZE);
+        return true;
+    case TCP_RECEIVE_SETTINGS:
+        if (settings.isEmpty()) {
+            return false;
+        }
+        socket->write(settings);
+        buffer.remove(0, 1);
+        return true;
+    case TCP_REGISTER_PLAYER: {
+        if (size < 8) {
+            return false;
+        }
+        quint8 player = data[1];
+        quint32 regId = qFromBigEndian<quint32>(data + 4);
+
+        char reply[2];
+        reply[0] = player < 4 && regId != 0
+                && (players[player].regId == 0 || players[player].regId == regId);
+        reply[1] = char(bufferSize);
+
+        if (reply[0]) {
+            players[player].regId = regId;
+            players[player].plugin = data[2];
+            players[player].raw = data[3];
+            if (!registrationClosed && !registrationTimer->isActive()) {
+                registrationTimer->start();
+            }
+            LOG(L_INFO, FROM, TR("Player <N> joined.")
+                    .replace("<N>", QString::number(player + 1)));
+        }
+        socket->write(reply, sizeof reply);
+        buffer.remove(0, 8);
+        return true;
+    }
+    case TCP_GET_REGISTRATION: {
+        int registered = 0;
+        for (int i = 0; i < 4; i++) {
+            registered += players[i].regId != 0;
+        }
+        if (!registrationClosed && registered < playerCount) {
+            return false;
+        }
+        registrationClosed = true;
+        registrationTimer->stop();
+
+        QByteArray reply;
+        QDataStream out(&reply, QIODevice::WriteOnly);
+        for (int i = 0; i < 4; i++) {
+            out << players[i].regId << players[i].plugin << players[i].raw;
+        }
+        socket->write(reply);
+        buffer.remove(0, 1);
+        return true;
+    }
+    case TCP_DISCONNECT_NOTICE: {
+        if (size < 5) {
+            return false;
+        }
+        quint32 regId = qFromBigEndian<quint32>(data + 1);
+        for (int i = 0; i < 4; i++) {
+            if (regId != 0 && players[i].regId == regId) {
+                status |= 1 << (i + 1);
+                LOG(L_INFO, FROM, TR("Player <N> left.")
+                        .replace("<N>", QString::number(i + 1)));
+            }
+        }
+        buffer.remove(0, 5);
+        return true;
+    }
+    }
+
+    buffer = QByteArray(1, char(0xff));
+    return false;
+}
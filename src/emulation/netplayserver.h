@@ -0,0 +1,132 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+
+#ifndef NETPLAYSERVER_H
+#define NETPLAYSERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QMap>
+#include <QObject>
+
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+class QUdpSocket;
+
+// A small stand-in for a netplay server, for testing netplay on one
+// machine: run it in one instance and connect two instances to it. It
+// speaks the core's netplay protocol and can delay every UDP packet to
+// simulate network latency and jitter. It answers the frontend's pings
+// with its view of each player so stalls and desyncs can be watched
+// while tuning the input delay.
+class NetplayServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NetplayServer(QObject *parent = 0);
+    ~NetplayServer();
+
+    bool listen(quint16 port);
+    void close();
+    bool isListening() const;
+
+    // Delay added to each UDP packet in each direction, plus a random
+    // extra delay of up to jitter milliseconds.
+    void setLatency(int latency, int jitter);
+    // Frames of input handed out ahead of the fastest client.
+    void setInputDelay(int frames);
+    // Buffer target sent to the clients when they register.
+    void setBufferSize(int frames);
+    // Players to wait for before telling the clients who plays.
+    void setPlayerCount(int count);
+
+private slots:
+    void acceptConnection();
+    void readTcp();
+    void readUdp();
+    void closeRegistration();
+
+private:
+    struct Input {
+        quint32 keys;
+        quint8 plugin;
+    };
+
+    struct Player {
+        quint32 regId;
+        quint8 plugin;
+        quint8 raw;
+        QHostAddress address;
+        quint16 port;
+        // Inputs by frame count, and the latest input the player sent.
+        QMap<quint32, Input> inputs;
+        Input pending;
+        quint8 bufferHealth;
+        quint8 lag;
+        quint32 stalls;
+    };
+
+    void reset();
+    int packetDelay() const;
+    void sendUdp(const QByteArray &packet, const QHostAddress &address, quint16 port);
+    void processUdp(const QByteArray &packet, const QHostAddress &address, quint16 port);
+    QByteArray inputPacket(quint8 type, quint8 player, quint32 count, bool spectator);
+    QByteArray pingReply(const QByteArray &ping) const;
+    void processTcp();
+    bool processRequest(QTcpSocket *socket, QByteArray &buffer);
+
+    QTcpServer *tcpServer;
+    QUdpSocket *udpSocket;
+    QTimer *registrationTimer;
+    QHash<QTcpSocket *, QByteArray> tcpBuffers;
+
+    int latency;
+    int jitter;
+    int inputDelay;
+    int bufferSize;
+    int playerCount;
+
+    Player players[4];
+    bool registrationClosed;
+    quint8 status;
+    quint32 leadCount;
+    QByteArray settings;
+    QHash<QString, QByteArray> saves;
+    QMap<quint32, QByteArray> syncValues;
+};
+
+#endif // NETPLAYSERVER_H
@@ -0,0 +1,240 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#include "sessionmemory.h"
+#include "../error.h"
+#include "../common.h"
+#include "../global.h"
+
+#include <QFile>
+#include <QList>
+#include <QSet>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#define FROM "memory"
+
+static bool enabled;
+static bool lockedAll;
+static long faultsAtStart;
+static long faultsAtRun;
+
+
+long majorFaults()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_majflt;
+    }
+#endif
+    return -1;
+}
+
+
+#ifdef Q_OS_UNIX
+struct MemoryRange {
+    quintptr start;
+    size_t length;
+};
+
+// Start of each mapping that existed before the ROM was opened.
+static QSet<quintptr> mappedAtStart;
+static QList<MemoryRange> lockedRanges;
+
+
+// Private anonymous mappings that can be written, which is where the
+// core and the plugins get their buffers from malloc and mmap. File
+// mappings like the cache pack and the GPU driver's are left out, and so
+// are the main heap and stack.
+static QList<MemoryRange> anonymousMappings()
+{
+    QList<MemoryRange> ranges;
+    QFile maps("/proc/self/maps");
+    if (!maps.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return ranges;
+    }
+
+    foreach (QByteArray line, maps.readAll().split('\n')) {
+        QList<QByteArray> fields = line.simplified().split(' ');
+        if (fields.size() != 5 || fields[1] != "rw-p") {
+            continue;
+        }
+        QList<QByteArray> bounds = fields[0].split('-');
+        if (bounds.size() != 2) {
+            continue;
+        }
+        MemoryRange range;
+        range.start = bounds[0].toULongLong(0, 16);
+        range.length = bounds[1].toULongLong(0, 16) - range.start;
+        ranges << range;
+    }
+    return ranges;
+}
+
+
+// Pages are only locked once they are used where the system supports it,
+// so address space that is reserved but never touched stays unlocked.
+static int lockRange(const MemoryRange &range)
+{
+#ifdef MLOCK_ONFAULT
+    return mlock2((void *)range.start, range.length, MLOCK_ONFAULT);
+#else
+    return mlock((void *)range.start, range.length);
+#endif
+}
+
+
+static void unlockRanges()
+{
+    foreach (const MemoryRange &range, lockedRanges) {
+        munlock((void *)range.start, range.length);
+    }
+    lockedRanges.clear();
+}
+#endif
+
+
+void startSessionMemory()
+{
+    enabled = SETTINGS.value("Emulation/lockmemory", "").toString() == "true";
+    lockedAll = false;
+    faultsAtStart = majorFaults();
+    faultsAtRun = -1;
+
+#ifdef Q_OS_UNIX
+    mappedAtStart.clear();
+    if (!enabled) {
+        return;
+    }
+    foreach (const MemoryRange &range, anonymousMappings()) {
+        mappedAtStart.insert(range.start);
+    }
+#endif
+}
+
+
+void lockSessionMemory()
+{
+    if (faultsAtRun < 0) {
+        faultsAtRun = majorFaults();
+    }
+
+#ifdef Q_OS_UNIX
+    if (!enabled || lockedAll) {
+        return;
+    }
+    // After the video plugin was switched, the game runs on memory that
+    // was allocated again.
+    unlockRanges();
+
+    // Use as much of the limit as we're allowed to.
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) != 0) {
+        return;
+    }
+    if (limit.rlim_cur != limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_MEMLOCK, &limit);
+    }
+
+    if (limit.rlim_cur == RLIM_INFINITY) {
+        // Memory the plugins allocate while running is locked too.
+        int flags = MCL_CURRENT | MCL_FUTURE;
+#ifdef MCL_ONFAULT
+        flags |= MCL_ONFAULT;
+#endif
+        lockedAll = mlockall(flags) == 0;
+        if (!lockedAll) {
+            LOG(L_WARN, FROM, TR("Could not lock memory: ") + strerror(errno));
+        }
+        return;
+    }
+
+    // Locking everything is checked against all mapped address space,
+    // which is far more than any limit allows. Only lock what the core
+    // and the plugins allocated for this game, which is all mapped by now.
+    QList<MemoryRange> ranges;
+    qint64 size = 0;
+    foreach (const MemoryRange &range, anonymousMappings()) {
+        if (!mappedAtStart.contains(range.start)) {
+            ranges << range;
+            size += range.length;
+        }
+    }
+    if (size > (qint64)limit.rlim_cur) {
+        LOG(L_WARN, FROM, TR("Not locking memory, the game uses <Size> MB but "
+                             "RLIMIT_MEMLOCK only allows <Limit> MB.")
+            .replace("<Size>", QString::number(size / 1024 / 1024))
+            .replace("<Limit>", QString::number(limit.rlim_cur / 1024 / 1024)));
+        return;
+    }
+
+    foreach (const MemoryRange &range, ranges) {
+        if (lockRange(range) != 0) {
+            LOG(L_WARN, FROM, TR("Could not lock memory: ") + strerror(errno));
+            unlockRanges();
+            return;
+        }
+        lockedRanges << range;
+    }
+#endif
+}
+
+
+void stopSessionMemory()
+{
+#ifdef Q_OS_UNIX
+    if (lockedAll) {
+        munlockall();
+        lockedAll = false;
+    }
+    unlockRanges();
+#endif
+
+    long faults = majorFaults();
+    if (faults < 0) {
+        return;
+    }
+    if (faultsAtRun < 0) {
+        faultsAtRun = faults;
+    }
+    LOG(L_INFO, FROM, TR("<Load> major page faults while loading, <Run> while running")
+        .replace("<Load>", QString::number(faultsAtRun - faultsAtStart))
+        .replace("<Run>", QString::number(faults - faultsAtRun)));
+}
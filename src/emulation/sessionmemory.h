@@ -0,0 +1,61 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#ifndef SESSIONMEMORY_H
+#define SESSIONMEMORY_H
+
+// Keeps the memory of an emulation session resident when
+// Emulation/lockmemory is enabled, so the game doesn't hitch when pages
+// get reclaimed on machines that are short on memory. Once the game is
+// running, all memory is locked if RLIMIT_MEMLOCK is unlimited, otherwise
+// only the memory the core and the plugins allocated for the game, if it
+// fits in the limit.
+//
+// Major page faults are always counted, and the number of faults while
+// loading and while running is logged when the session ends.
+//
+// Only does something on Unix-like systems. All functions are called from
+// the emulation thread.
+
+// Called before the ROM is opened.
+void startSessionMemory();
+
+// Called when the game has started running, after the core allocated its
+// memory. Called again when it runs again after switching video plugins.
+void lockSessionMemory();
+
+void stopSessionMemory();
+
+// Major page faults of the process so far, or -1 if not known.
+long majorFaults();
+
+#endif // SESSIONMEMORY_H
@@ -31,6 +31,7 @@
 
 #include "vidext.h"
 #include "glwindow.h"
+#include "frametelemetry.h"
 #include "emulation.h"
 #include "../error.h"
 #include "../common.h"
@@ -39,13 +40,50 @@
 #include <m64p_types.h>
 #include <QApplication>
 #include <QDesktopWidget>
+#include <QScreen>
 
 #define FROM "vidext"
 
 GlWindow *glWindow;
 static QSurfaceFormat format;
+// Whether the video plugin asked for an alpha channel itself.
+static bool alphaRequested;
+static QList<QSize> displayModes;
 extern Emulation emulation;
 
+
+static bool sizeGreater(const QSize &a, const QSize &b)
+{
+    return a.width() * a.height() > b.width() * b.height();
+}
+
+
+void updateDisplayModes()
+{
+    // Qt only knows the current mode of each screen and fullscreen never
+    // changes it. Offer the native sizes and the usual smaller sizes that
+    // fit on a screen, which get scaled up.
+    static const QSize commonSizes[] = {
+        QSize(640, 480), QSize(800, 600), QSize(1024, 768),
+        QSize(1280, 720), QSize(1280, 960), QSize(1600, 1200),
+        QSize(1920, 1080), QSize(2560, 1440), QSize(3840, 2160),
+    };
+
+    displayModes.clear();
+    foreach (QScreen *screen, QGuiApplication::screens()) {
+        QSize native = screen->size() * screen->devicePixelRatio();
+        if (!displayModes.contains(native))
+            displayModes << native;
+
+        for (const QSize &size : commonSizes) {
+            if (size.width() <= native.width() && size.height() <= native.height()
+                    && !displayModes.contains(size))
+                displayModes << size;
+        }
+    }
+    qSort(displayModes.begin(), displayModes.end(), sizeGreater);
+}
+
 static m64p_error init()
 {
     LOG(L_VERB, FROM, "init");
@@ -54,12 +92,17 @@ static m64p_error init()
     format.setMinorVersion(1);
     format.setProfile(QSurfaceFormat::CompatibilityProfile);
     format.setDepthBufferSize(24);
+    alphaRequested = false;
+    if (SETTINGS.value("Graphics/gldebug", "").toString() == "true") {
+        format.setOption(QSurfaceFormat::DebugContext);
+    }
     return M64ERR_SUCCESS;
 }
 
 static m64p_error quit()
 {
     LOG(L_VERB, FROM, "quit");
+    stopFrameTelemetry();
     glWindow->doneCurrent();
     glWindow->context()->moveToThread(QApplication::instance()->thread());
     emulation.destroyGlWindow();
@@ -69,15 +112,37 @@ static m64p_error quit()
 static m64p_error listModes(m64p_2d_size *sizes, int *nSizes)
 {
     LOG(L_VERB, FROM, "listModes");
-    abort();
+    int count = qMin(*nSizes, displayModes.size());
+    for (int i = 0; i < count; i++) {
+        sizes[i].uiWidth = displayModes[i].width();
+        sizes[i].uiHeight = displayModes[i].height();
+    }
+    *nSizes = count;
+    return M64ERR_SUCCESS;
 }
 
 static m64p_error setMode(int width, int height, int, int mode, int)
 {
     LOG(L_VERB, FROM, "setMode");
-    emulation.createGlWindow(&format);
+    bool fullscreen = mode == M64VIDEO_FULLSCREEN
+        || SETTINGS.value("Graphics/fullscreen", "") == "true";
+    if (fullscreen && !alphaRequested) {
+        // An opaque fullscreen surface can be scanned out directly by
+        // Wayland compositors instead of being blended. Plugins that ask
+        // for alpha get it, since they may read it back.
+        format.setAlphaBufferSize(0);
+    }
+    emulation.createGlWindow(&format, fullscreen);
     emulation.resize(width, height);
     glWindow->makeCurrent();
+
+    QString surface = TR("windowed");
+    if (fullscreen && isCompositorBypassed())
+        surface = TR("fullscreen, compositor bypassed");
+    else if (fullscreen)
+        surface = TR("fullscreen");
+    startFrameTelemetry(glWindow->context(),
+                        emulation.currentVideoPlugin() + ", " + surface);
     return M64ERR_SUCCESS;
 }
 
@@ -121,6 +186,7 @@ static m64p_error glSetAttr(m64p_GLattr attr, int value)
     case M64P_GL_ALPHA_SIZE:
         LOG(L_VERB, FROM, "glSetAttr: M64P_GL_ALPHA_SIZE");
         format.setAlphaBufferSize(value);
+        alphaRequested = true;
         return M64ERR_SUCCESS;
     case M64P_GL_SWAP_CONTROL:
         LOG(L_VERB, FROM, "glSetAttr: M64P_GL_SWAP_CONTROL");
@@ -193,7 +259,9 @@ static m64p_error glGetAttr(m64p_GLattr attr, int *value)
 static m64p_error glSwapBuf()
 {
     //LOG(L_VERB, FROM, "glSwapBuf");
+    frameTelemetryBeforeSwap();
     glWindow->context()->swapBuffers(glWindow);
+    frameTelemetryAfterSwap();
     return M64ERR_SUCCESS;
 }
 
@@ -207,6 +275,7 @@ static m64p_error toggleFs()
 {
     LOG(L_VERB, FROM, "toggleFs");
     emulation.toggleFullscreen();
+    return M64ERR_SUCCESS;
 }
 
 static m64p_error resizeWindow(int, int)
@@ -36,4 +36,9 @@
 
 extern m64p_video_extension_functions vidextFunctions;
 
+// Reads the sizes offered to the video plugin from the connected screens.
+// QScreen can only be used from the GUI thread, so this is called there
+// before the emulation thread starts.
+void updateDisplayModes();
+
 #endif // VIDEXT_H
@@ -34,11 +34,13 @@
 #include "common.h"
 #include "mainwindow.h"
 #include "core.h"
+#include "prefetch.h"
 #include "emulation/emulation.h"
 
 #include <QApplication>
 #include <QDesktopWidget>
 #include <QFileInfo>
+#include <QTimer>
 #include <QTranslator>
 
 Emulation emulation;
@@ -62,6 +64,8 @@ int main(int argc, char *argv[])
     QCoreApplication::setOrganizationName(AppName);
     QCoreApplication::setApplicationName(AppName);
 
+    startStartupPrefetch();
+
     Core core;
     core.init();
 
@@ -84,5 +88,8 @@ int main(int argc, char *argv[])
                 - window.rect().center());
     }
 
+    // Startup is over once the window has been shown.
+    QTimer::singleShot(0, finishStartupRecording);
+
     return application.exec();
 }
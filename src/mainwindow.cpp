@@ -44,11 +44,13 @@
 #include "dialogs/downloaddialog.h"
 #include "dialogs/gamesettingsdialog.h"
 #include "dialogs/logdialog.h"
+#include "dialogs/netplaydialog.h"
 #include "dialogs/settingsdialog.h"
 #include "dialogs/inputdialog.h"
 
 #include "emulation/glwindow.h"
 #include "emulation/emulation.h"
+#include "emulation/netplay.h"
 
 #include "roms/romcollection.h"
 #include "roms/thegamesdbscraper.h"
@@ -84,18 +86,26 @@ MainWindow::MainWindow(QWidget *parent)
     setWindowTitle(AppName);
     setWindowIcon(QIcon(":/images/"+AppNameLower+".png"));
     installEventFilter(this);
+    netplayDialog = NULL;
+    netplayMonitor = new NetplayMonitor(this);
+    gameFullscreen = false;
 
     autoloadSettings();
 
+    activeLayout = SETTINGS.value("View/layout", "table").toString();
+
     romCollection = new RomCollection(QStringList() << "*.z64" << "*.v64" << "*.n64" << "*.zip",
                                       QStringList() << SETTINGS.value("Paths/roms","").toString().split("|"),
                                       this);
+    loadGameSettings();
     createMenu();
     createRomView();
 
     connect(&emulation, SIGNAL(started()),
             this, SLOT(disableButtons()),
             Qt::BlockingQueuedConnection);
+    connect(&emulation, SIGNAL(started()), this, SLOT(startNetplayMonitor()));
+    connect(&emulation, SIGNAL(finished()), netplayMonitor, SLOT(stop()));
     connect(&emulation, SIGNAL(resumed()), this, SLOT(emulationResumed()));
     connect(&emulation, SIGNAL(paused()), this, SLOT(emulationPaused()));
     connect(&emulation, SIGNAL(toggleFullscreen()), this, SLOT(toggleFullscreen()));
@@ -103,8 +113,8 @@ MainWindow::MainWindow(QWidget *parent)
             this, SLOT(destroyGlWindow()),
             Qt::BlockingQueuedConnection);
     connect(&emulation, SIGNAL(finished()), this, SLOT(enableButtons()));
-    connect(&emulation, SIGNAL(createGlWindow(QSurfaceFormat*)),
-            this, SLOT(createGlWindow(QSurfaceFormat*)),
+    connect(&emulation, SIGNAL(createGlWindow(QSurfaceFormat*, bool)),
+            this, SLOT(createGlWindow(QSurfaceFormat*, bool)),
             Qt::BlockingQueuedConnection);
     connect(&emulation, SIGNAL(resize(int, int)),
             this, SLOT(resizeWindow(int, int)),
@@ -115,6 +125,7 @@ MainWindow::MainWindow(QWidget *parent)
     connect(romCollection, SIGNAL(updateEnded(int, bool)), this, SLOT(enableViews(int, bool)));
 
     romCollection->cachedRoms(false, true);
+    migrateGameSettings(romCollection->getRoms());
 
 
     setMenuBar(menuBar);
@@ -145,7 +156,7 @@ MainWindow::MainWindow(QWidget *parent)
 }
 
 
-void MainWindow::createGlWindow(QSurfaceFormat *format)
+void MainWindow::createGlWindow(QSurfaceFormat *format, bool fullscreen)
 {
     mainGeometry = saveGeometry();
     extern GlWindow *glWindow;
@@ -172,9 +183,11 @@ void MainWindow::createGlWindow(QSurfaceFormat *format)
                 - rect().center());
     }
 
-    if (SETTINGS.value("Graphics/fullscreen", "") == "true") {
+    gameFullscreen = fullscreen;
+    if (fullscreen) {
         QMainWindow::menuBar()->setHidden(true);
         showFullScreen();
+        setCompositorBypass(windowHandle(), true);
     }
 
     m64p_rom_settings romSettings;
@@ -198,7 +211,8 @@ void MainWindow::destroyGlWindow()
     setCentralWidget(mainWidget);
     SETTINGS.setValue("Geometry/gameWindowx", geometry().x());
     SETTINGS.setValue("Geometry/gameWindowy", geometry().y());
-    if (SETTINGS.value("Graphics/fullscreen", "") == "true") {
+    if (gameFullscreen) {
+        setCompositorBypass(windowHandle(), false);
         // Don't know why but have to go fullscreen before going back,
         // otherwise it doesn't go back properly.
         showFullScreen();
@@ -225,18 +239,29 @@ void MainWindow::resizeWindow(int width, int height)
 
 void MainWindow::addToView(Rom *currentRom, int count)
 {
-    QString visibleLayout = SETTINGS.value("View/layout", "table").toString();
-
-    if (visibleLayout == "table") {
+    if (activeLayout == "table") {
         tableView->addToTableView(currentRom);
-    } else if (visibleLayout == "grid") {
+    } else if (activeLayout == "grid") {
         gridView->addToGridView(currentRom, count, false);
-    } else if (visibleLayout == "list") {
+    } else if (activeLayout == "list") {
         listView->addToListView(currentRom, count, false);
     }
 }
 
 
+// The built-in plugins are never picked automatically, since a game
+// would then run without sound or input and without a warning.
+static QString firstRealPlugin(const QStringList &plugins)
+{
+    foreach (QString plugin, plugins) {
+        if (!isBuiltinPlugin(plugin)) {
+            return plugin;
+        }
+    }
+    return "";
+}
+
+
 void MainWindow::autoloadSettings()
 {
     QString pluginPath = SETTINGS.value("Paths/plugins", "").toString();
@@ -315,7 +340,7 @@ void MainWindow::autoloadSettings()
 
     p = getCurrentAudioPlugin();
     if (p == "") {
-        p = getAvailableAudioPlugins().value(0);
+        p = firstRealPlugin(getAvailableAudioPlugins());
     }
     if (p != "") {
         SETTINGS.setValue("Plugins/audio", p);
@@ -323,7 +348,7 @@ void MainWindow::autoloadSettings()
 
     p = getCurrentInputPlugin();
     if (p == "") {
-        p = getAvailableInputPlugins().value(0);
+        p = firstRealPlugin(getAvailableInputPlugins());
     }
     if (p != "") {
         SETTINGS.setValue("Plugins/input", p);
@@ -449,7 +474,9 @@ void MainWindow::createMenu()
             }
         });
     }
+    videoPluginMenu = emulationMenu->addMenu(tr("S&witch video plugin"));
     cheatsAction = emulationMenu->addAction(tr("&Cheats..."));
+    netplayAction = emulationMenu->addAction(tr("&Netplay..."));
 
     {
         QList<QKeySequence> seq;
@@ -481,6 +508,7 @@ void MainWindow::createMenu()
     stopAction->setEnabled(false);
     saveStateAction->setEnabled(false);
     loadStateAction->setEnabled(false);
+    videoPluginMenu->setEnabled(false);
 
     menuBar->addMenu(emulationMenu);
 
@@ -493,6 +521,8 @@ void MainWindow::createMenu()
     connect(loadStateAction, SIGNAL(triggered()), &emulation, SLOT(loadState()));
     connect(stopAction, SIGNAL(triggered()), this, SLOT(stopEmulator()));
     connect(cheatsAction, SIGNAL(triggered()), this, SLOT(showCheats()));
+    connect(netplayAction, SIGNAL(triggered()), this, SLOT(showNetplay()));
+    connect(videoPluginMenu, SIGNAL(aboutToShow()), this, SLOT(updateVideoPluginMenu()));
 
 
     // Settings
@@ -598,7 +628,8 @@ void MainWindow::createMenu()
                 << frameAction
                 << resetAction
                 << saveStateAction
-                << loadStateAction;
+                << loadStateAction
+                << videoPluginMenu->menuAction();
 
     // List of actions that are only active when a ROM is selected
     menuRomSelected << startAction
@@ -691,6 +722,7 @@ void MainWindow::disableViews(bool imageUpdated)
 
     resetLayouts(imageUpdated);
     tableView->clear();
+    populatedLayouts.clear();
 
     tableView->setEnabled(false);
     gridView->setEnabled(false);
@@ -711,6 +743,7 @@ void MainWindow::enableButtons()
 void MainWindow::enableViews(int romCount, bool cached)
 {
     QString visibleLayout = SETTINGS.value("View/layout", "table").toString();
+    populatedLayouts.insert(visibleLayout);
 
     // Else no ROMs, so leave views disabled
     if (romCount != 0) {
@@ -923,7 +956,9 @@ void MainWindow::openPlugins()
 
 void MainWindow::openInputConfig()
 {
-    if (getCurrentInputPlugin() != "") {
+    if (isBuiltinPlugin(getCurrentInputPlugin())) {
+        SHOW_I(tr("The built-in plugin has no settings."));
+    } else if (getCurrentInputPlugin() != "") {
         InputDialog().exec();
     } else {
         SHOW_I(tr("Go to settings and select an input plugin first"));
@@ -953,7 +988,9 @@ void MainWindow::openEditor()
 
 void MainWindow::openGameSettings()
 {
-    GameSettingsDialog gameSettingsDialog(getCurrentRomInfoFromView("fileName"), this);
+    GameSettingsDialog gameSettingsDialog(getCurrentRomInfoFromView("fileName"),
+                                          getCurrentRomInfoFromView("romMD5"),
+                                          this);
     gameSettingsDialog.exec();
 }
 
@@ -1097,6 +1134,26 @@ void MainWindow::openZipDialog(QStringList zippedFiles)
 }
 
 
+void MainWindow::populateView(const QString &layout)
+{
+    // Build the view from the ROMs already in memory instead of going
+    // through the database, catalog and cache again.
+    const QList<Rom> &roms = romCollection->getRoms();
+
+    for (int i = 0; i < roms.size(); i++) {
+        if (layout == "table") {
+            tableView->addToTableView(&roms[i]);
+        } else if (layout == "grid") {
+            gridView->addToGridView(&roms[i], i, false);
+        } else if (layout == "list") {
+            listView->addToListView(&roms[i], i, false);
+        }
+    }
+
+    populatedLayouts.insert(layout);
+}
+
+
 void MainWindow::resetLayouts(bool imageUpdated)
 {
     tableView->resetView(imageUpdated);
@@ -1177,6 +1234,43 @@ void MainWindow::showCheats()
 }
 
 
+void MainWindow::showNetplay()
+{
+    // Not modal, so the statistics can be watched while playing.
+    if (!netplayDialog) {
+        netplayDialog = new NetplayDialog(netplayMonitor, this);
+    }
+    netplayDialog->show();
+    netplayDialog->raise();
+    netplayDialog->activateWindow();
+}
+
+
+void MainWindow::startNetplayMonitor()
+{
+    if (isNetplayEnabled()) {
+        netplayMonitor->start(SETTINGS.value("Netplay/host", "127.0.0.1").toString(),
+                              SETTINGS.value("Netplay/port", NETPLAY_DEFAULT_PORT).toInt());
+    }
+}
+
+
+void MainWindow::updateVideoPluginMenu()
+{
+    videoPluginMenu->clear();
+    QString current = emulation.currentVideoPlugin();
+
+    foreach (QString name, getAvailableVideoPlugins()) {
+        QAction *action = videoPluginMenu->addAction(name);
+        action->setCheckable(true);
+        action->setChecked(name == current);
+        connect(action, &QAction::triggered, [name]() {
+            emulation.switchVideoPlugin(name);
+        });
+    }
+}
+
+
 void MainWindow::toggleMenus(bool active)
 {
     foreach (QAction *next, menuEnable) {
@@ -1235,6 +1329,7 @@ void MainWindow::updateLayoutSetting()
 {
     QString visibleLayout = layoutGroup->checkedAction()->data().toString();
     SETTINGS.setValue("View/layout", visibleLayout);
+    activeLayout = visibleLayout;
 
     emptyView->setHidden(true);
     tableView->setHidden(true);
@@ -1242,10 +1337,18 @@ void MainWindow::updateLayoutSetting()
     listView->setHidden(true);
     disabledView->setHidden(true);
 
-    int romCount = romCollection->cachedRoms();
+    // Every layout shows the same collection, so a view only has to be
+    // built the first time it is shown after the collection changed.
+    if (!populatedLayouts.contains(visibleLayout)) {
+        populateView(visibleLayout);
+    }
+
+    int romCount = romCollection->getRoms().size();
 
     if (romCount > 0 || visibleLayout == "none") {
         showActiveView();
+    } else {
+        disabledView->setHidden(false);
     }
 
     // View was updated so no ROM will be selected. Update menu items accordingly
@@ -1270,5 +1373,7 @@ void MainWindow::emulationPaused()
 
 void MainWindow::toggleFullscreen()
 {
+    gameFullscreen = true;
     showFullScreen();
+    setCompositorBypass(windowHandle(), true);
 }
@@ -35,6 +35,7 @@
 
 
 #include <QMainWindow>
+#include <QSet>
 #include <QSurfaceFormat>
 
 class QActionGroup;
@@ -50,6 +51,8 @@ class QVBoxLayout;
 class EmulatorHandler;
 class GridView;
 class ListView;
+class NetplayDialog;
+class NetplayMonitor;
 class RomCollection;
 class TableView;
 class TheGamesDBScraper;
@@ -73,6 +76,7 @@ private:
     void createMenu();
     void createRomView();
     void openZipDialog(QStringList zippedFiles);
+    void populateView(const QString &layout);
     void resetLayouts(bool imageUpdated = false);
     void showActiveView();
     void openSettings(int tab);
@@ -80,6 +84,11 @@ private:
     QString getCurrentRomInfoFromView(QString infoName);
     QString openPath;
 
+    // Layout that ROMs are added to while the collection is updated,
+    // and the layouts that currently hold the whole collection.
+    QString activeLayout;
+    QSet<QString> populatedLayouts;
+
     QAction *aboutAction;
     QAction *configureAction;
     QAction *configureGameAction;
@@ -102,6 +111,7 @@ private:
     QAction *loadStateAction;
     QAction *stopAction;
     QAction *cheatsAction;
+    QAction *netplayAction;
     QActionGroup *layoutGroup;
     QDialog *zipDialog;
     QDialogButtonBox *zipButtonBox;
@@ -117,6 +127,7 @@ private:
     QMenu *fileMenu;
     QMenu *helpMenu;
     QMenu *slotMenu;
+    QMenu *videoPluginMenu;
     QMenu *layoutMenu;
     QMenu *settingsMenu;
     QMenu *viewMenu;
@@ -130,11 +141,14 @@ private:
     GridView *gridView;
     ListView *listView;
     RomCollection *romCollection;
+    NetplayDialog *netplayDialog;
+    NetplayMonitor *netplayMonitor;
     TableView *tableView;
     TheGamesDBScraper *scraper;
     TreeWidgetItem *fileItem;
     // Saved when a game is started so we can restore the window.
     QByteArray mainGeometry;
+    bool gameFullscreen;
 
 private slots:
     void addToView(Rom *currentRom, int count);
@@ -156,13 +170,16 @@ private slots:
     void openLog();
     void openSettings();
     void openRom();
-    void createGlWindow(QSurfaceFormat *format);
+    void createGlWindow(QSurfaceFormat *format, bool fullscreen);
     void destroyGlWindow();
     void resizeWindow(int width, int height);
     void showMenuBar(bool mouseAtTop);
     void showRomMenu(const QPoint &);
     void stopEmulator();
     void showCheats();
+    void showNetplay();
+    void startNetplayMonitor();
+    void updateVideoPluginMenu();
     void toggleMenus(bool active);
     void updateFullScreenMode();
     void updateLayoutSetting();
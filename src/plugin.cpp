@@ -34,8 +34,10 @@
 #include "common.h"
 #include "core.h"
 #include "error.h"
+#include "settings.h"
 #include "osal/osal_dynamiclib.h"
 
+#include <QCoreApplication>
 #include <QString>
 
 #ifdef Q_OS_WIN
@@ -48,6 +50,10 @@
 
 static QString findPlugin(const char *name)
 {
+    if (name == ScriptPlugin) {
+        return QCoreApplication::applicationDirPath() + "/" + ScriptPluginLibrary
+            + FILENAME_EXTENSION;
+    }
     QString dir = SETTINGS.value("Paths/plugins", "").toString();
     return dir + "/" + name + FILENAME_EXTENSION;
 }
@@ -0,0 +1,20 @@
+# Input plugin that plays the controller input of an input script. It is
+# built with the frontend and installed next to it, see inputscript.h.
+
+TEMPLATE = lib
+CONFIG  += plugin no_plugin_name_prefix c++11
+CONFIG  -= qt
+
+# A static Qt build (like MXE's) puts static in CONFIG, which would build
+# an archive instead of a library the core can load
+CONFIG  += shared
+CONFIG  -= static staticlib
+TARGET   = mupen64plus-input-script
+DESTDIR  = ../../..
+
+# The frontend looks for plugins with the .so extension on macOS too
+macx: QMAKE_EXTENSION_SHLIB = so
+
+SOURCES += inputscriptplugin.cpp
+
+INCLUDEPATH += /usr/local/include/mupen64plus
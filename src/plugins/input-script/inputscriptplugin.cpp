@@ -0,0 +1,173 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+
+// The script input plugin. It has no devices and no configuration; the
+// controller state comes from the frontend, which plays the input script
+// and hands the state over through the Script* functions below. Both run
+// in the emulation thread.
+
+#define M64P_PLUGIN_PROTOTYPES 1
+#include <m64p_common.h>
+#include <m64p_plugin.h>
+#include <m64p_types.h>
+
+#include <cstring>
+
+#define PLUGIN_NAME       "Input script"
+#define PLUGIN_VERSION    0x010000
+#define INPUT_API_VERSION 0x020100
+
+static bool started = false;
+static int present[4] = {1, 0, 0, 0};
+static unsigned int buttons[4];
+
+
+extern "C" {
+
+EXPORT m64p_error CALL PluginStartup(m64p_dynlib_handle, void *,
+                                     void (*)(void *, int, const char *))
+{
+    if (started) {
+        return M64ERR_ALREADY_INIT;
+    }
+    started = true;
+    return M64ERR_SUCCESS;
+}
+
+
+EXPORT m64p_error CALL PluginShutdown(void)
+{
+    if (!started) {
+        return M64ERR_NOT_INIT;
+    }
+    started = false;
+    return M64ERR_SUCCESS;
+}
+
+
+EXPORT m64p_error CALL PluginGetVersion(m64p_plugin_type *pluginType,
+                                        int *pluginVersion, int *apiVersion,
+                                        const char **pluginNamePtr,
+                                        int *capabilities)
+{
+    if (pluginType) {
+        *pluginType = M64PLUGIN_INPUT;
+    }
+    if (pluginVersion) {
+        *pluginVersion = PLUGIN_VERSION;
+    }
+    if (apiVersion) {
+        *apiVersion = INPUT_API_VERSION;
+    }
+    if (pluginNamePtr) {
+        *pluginNamePtr = PLUGIN_NAME;
+    }
+    if (capabilities) {
+        *capabilities = 0;
+    }
+    return M64ERR_SUCCESS;
+}
+
+
+EXPORT void CALL InitiateControllers(CONTROL_INFO controlInfo)
+{
+    for (int i = 0; i < 4; i++) {
+        controlInfo.Controls[i].Present = present[i];
+        controlInfo.Controls[i].RawData = 0;
+        controlInfo.Controls[i].Plugin = PLUGIN_MEMPAK;
+    }
+}
+
+
+EXPORT void CALL GetKeys(int control, BUTTONS *keys)
+{
+    keys->Value = control >= 0 && control < 4 ? buttons[control] : 0;
+}
+
+
+EXPORT void CALL ControllerCommand(int, unsigned char *)
+{
+}
+
+
+EXPORT void CALL ReadController(int, unsigned char *)
+{
+}
+
+
+EXPORT int CALL RomOpen(void)
+{
+    memset(buttons, 0, sizeof buttons);
+    return 1;
+}
+
+
+EXPORT void CALL RomClosed(void)
+{
+}
+
+
+EXPORT void CALL SDL_KeyDown(int, int)
+{
+}
+
+
+EXPORT void CALL SDL_KeyUp(int, int)
+{
+}
+
+
+EXPORT void CALL RenderCallback(void)
+{
+}
+
+
+// Not part of the plugin API, called by the frontend. Which controllers
+// are plugged in must be set before the game is executed.
+
+EXPORT void CALL ScriptSetPresent(int control, int isPresent)
+{
+    if (control >= 0 && control < 4) {
+        present[control] = isPresent;
+    }
+}
+
+
+EXPORT void CALL ScriptSetButtons(int control, unsigned int value)
+{
+    if (control >= 0 && control < 4) {
+        buttons[control] = value;
+    }
+}
+
+} // extern "C"
@@ -0,0 +1,317 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+
+#include "prefetch.h"
+#include "common.h"
+#include "error.h"
+#include "global.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QSaveFile>
+#include <QStringList>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define FROM "prefetch"
+
+#define PREFETCH_MAGIC   0x4d363450
+#define PREFETCH_VERSION 1
+#define PREFETCH_THREADS 4
+// Ranges closer than this are read as one.
+#define MERGE_GAP (64 * 1024)
+// Mapped files with more mapped than this are not prefetched.
+#define MAX_MAPPED_SIZE (16 * 1024 * 1024)
+
+struct Range {
+    qint64 offset;
+    qint64 length;  // -1 for the rest of the file.
+};
+
+struct FileReads {
+    QString fileName;
+    QList<Range> ranges;
+};
+
+
+static bool recording = false;
+static QList<FileReads> recorded;
+static QHash<QString, int> recordedIndex;
+
+
+static QString listFileName()
+{
+    return getCacheLocation() + "startup.prefetch";
+}
+
+
+class PrefetchThread : public QThread
+{
+public:
+    PrefetchThread(const QList<FileReads> &files)
+        : files(files)
+    {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+#ifdef Q_OS_LINUX
+        foreach (const FileReads &file, files) {
+            int fd = ::open(file.fileName.toLocal8Bit().constData(), O_RDONLY);
+            if (fd < 0) {
+                continue;
+            }
+            foreach (const Range &range, file.ranges) {
+                qint64 length = range.length < 0 ? 0 : range.length;
+                posix_fadvise(fd, range.offset, length, POSIX_FADV_WILLNEED);
+            }
+            ::close(fd);
+        }
+#endif
+    }
+
+private:
+    QList<FileReads> files;
+};
+
+
+static QList<FileReads> readList()
+{
+    QList<FileReads> files;
+    QFile file(listFileName());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return files;
+    }
+
+    QDataStream in(&file);
+    quint32 magic, count;
+    quint16 version;
+    in >> magic >> version >> count;
+    if (magic != PREFETCH_MAGIC || version != PREFETCH_VERSION) {
+        return files;
+    }
+
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        FileReads reads;
+        quint32 rangeCount;
+        in >> reads.fileName >> rangeCount;
+        for (quint32 j = 0; j < rangeCount && in.status() == QDataStream::Ok; j++) {
+            Range range;
+            in >> range.offset >> range.length;
+            reads.ranges << range;
+        }
+        files << reads;
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        return QList<FileReads>();
+    }
+    return files;
+}
+
+
+// Sorts the ranges and joins the ones that overlap or nearly touch.
+static QList<Range> mergeRanges(const QList<Range> &ranges)
+{
+    QMap<qint64, qint64> sorted;
+    foreach (const Range &range, ranges) {
+        if (range.length < 0) {
+            return QList<Range>() << Range{0, -1};
+        }
+        qint64 end = range.offset + range.length;
+        sorted[range.offset] = qMax(sorted.value(range.offset), end);
+    }
+
+    QList<Range> merged;
+    for (auto it = sorted.constBegin(); it != sorted.constEnd(); ++it) {
+        if (!merged.isEmpty()) {
+            Range &last = merged.last();
+            if (it.key() <= last.offset + last.length + MERGE_GAP) {
+                last.length = qMax(last.length, it.value() - last.offset);
+                continue;
+            }
+        }
+        merged << Range{it.key(), it.value() - it.key()};
+    }
+    return merged;
+}
+
+
+// Libraries are mapped rather than read, so they are found in the
+// process' mappings instead of being recorded where they are used. Only
+// the mapped parts are recorded, and files that were recorded where they
+// were read, like the cache pack, are left as they are. Big mapped files
+// like the locale archive or a GPU driver's compiler are mostly never
+// touched, so reading them ahead would cost more than it saves.
+static void recordMappedFiles()
+{
+#ifdef Q_OS_LINUX
+    QFile maps("/proc/self/maps");
+    if (!maps.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return;
+    }
+
+    QStringList fileNames;
+    QHash<QString, QList<Range> > mapped;
+    foreach (QByteArray line, maps.readAll().split('\n')) {
+        int slash = line.indexOf('/');
+        if (slash < 0) {
+            continue;
+        }
+        QString fileName = QString::fromLocal8Bit(line.mid(slash).trimmed());
+        if (fileName.startsWith("/dev/") || fileName.endsWith(" (deleted)")
+                || fileName.endsWith("/locale-archive")
+                || recordedIndex.contains(fileName)) {
+            continue;
+        }
+
+        // start-end perms offset device inode
+        QList<QByteArray> fields = line.left(slash).simplified().split(' ');
+        QList<QByteArray> bounds = fields[0].split('-');
+        if (fields.size() < 3 || bounds.size() != 2) {
+            continue;
+        }
+        Range range;
+        range.offset = fields[2].toLongLong(0, 16);
+        range.length = bounds[1].toLongLong(0, 16) - bounds[0].toLongLong(0, 16);
+
+        if (!mapped.contains(fileName)) {
+            fileNames << fileName;
+        }
+        mapped[fileName] << range;
+    }
+
+    foreach (const QString &fileName, fileNames) {
+        QList<Range> ranges = mapped.value(fileName);
+        qint64 size = 0;
+        foreach (const Range &range, ranges) {
+            size += range.length;
+        }
+        if (size > MAX_MAPPED_SIZE) {
+            continue;
+        }
+        foreach (const Range &range, ranges) {
+            recordStartupRead(fileName, range.offset, range.length);
+        }
+    }
+#endif
+}
+
+
+void startStartupPrefetch()
+{
+    if (SETTINGS.value("Other/prefetch", "true").toString() != "true") {
+        return;
+    }
+    recording = true;
+
+    QList<FileReads> files = readList();
+    if (files.isEmpty()) {
+        return;
+    }
+
+    // Each thread takes every few files, so the first files needed are
+    // asked for first, and one slow open doesn't hold up the rest.
+    for (int i = 0; i < PREFETCH_THREADS; i++) {
+        QList<FileReads> share;
+        for (int j = i; j < files.size(); j += PREFETCH_THREADS) {
+            share << files[j];
+        }
+        PrefetchThread *thread = new PrefetchThread(share);
+        QObject::connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+        thread->start(QThread::LowPriority);
+    }
+    LOG(L_VERB, FROM, TR("Prefetching <N> files").replace("<N>", QString::number(files.size())));
+}
+
+
+void recordStartupRead(const QString &fileName, qint64 offset, qint64 length)
+{
+    if (!recording || fileName == "") {
+        return;
+    }
+
+    int index = recordedIndex.value(fileName, -1);
+    if (index < 0) {
+        index = recorded.size();
+        recordedIndex.insert(fileName, index);
+        recorded << FileReads{fileName, QList<Range>()};
+    }
+
+    QList<Range> &ranges = recorded[index].ranges;
+    if (!ranges.isEmpty() && ranges.first().length < 0) {
+        return;  // Already the whole file.
+    }
+    if (length < 0) {
+        ranges = QList<Range>() << Range{0, -1};
+    } else {
+        ranges << Range{offset, length};
+    }
+}
+
+
+void finishStartupRecording()
+{
+    if (!recording) {
+        return;
+    }
+    recordMappedFiles();
+    recording = false;
+
+    QSaveFile file(listFileName());
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG(L_WARN, FROM, TR("Could not save ") + file.fileName());
+        return;
+    }
+
+    QDataStream out(&file);
+    out << quint32(PREFETCH_MAGIC) << quint16(PREFETCH_VERSION)
+        << quint32(recorded.size());
+    foreach (const FileReads &reads, recorded) {
+        QList<Range> ranges = mergeRanges(reads.ranges);
+        out << reads.fileName << quint32(ranges.size());
+        foreach (const Range &range, ranges) {
+            out << range.offset << range.length;
+        }
+    }
+    file.commit();
+
+    recorded.clear();
+    recordedIndex.clear();
+}
@@ -0,0 +1,61 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <QtGlobal>
+
+class QString;
+
+// Cold starts are slow because of many small reads spread over the
+// database, the catalog, the cover and info cache and the libraries. The
+// files and ranges read during a startup are recorded, and on the next
+// startup a few background threads ask the kernel to read them ahead with
+// posix_fadvise(WILLNEED), in the order they were needed last time.
+//
+// Controlled by Other/prefetch, which is on by default. Only prefetches
+// on Linux. All functions except the prefetching itself run in the GUI
+// thread.
+
+// Starts prefetching what the last startup read and starts recording.
+void startStartupPrefetch();
+
+// Records that a range of a file was read during startup. A length of -1
+// means the whole file. Does nothing once startup is over.
+void recordStartupRead(const QString &fileName, qint64 offset = 0, qint64 length = -1);
+
+// Stops recording and saves what was read for the next startup.
+void finishStartupRecording();
+
+#endif // PREFETCH_H
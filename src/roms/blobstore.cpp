@@ -0,0 +1,399 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#include "blobstore.h"
+#include "../common.h"
+#include "../error.h"
+#include "../prefetch.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QRegExp>
+#include <QSaveFile>
+
+#define INDEX_MAGIC   0x4d363442
+#define INDEX_VERSION 1
+
+// Size of the record header: key size and data size, each 32 bits.
+#define HEADER_SIZE 8
+// Data size written for a removed blob.
+#define REMOVED -1
+
+// Compact when at least this much of the pack is garbage, and garbage is
+// at least half of the pack.
+#define COMPACT_MIN_GARBAGE (4 * 1024 * 1024)
+
+
+BlobStore &BlobStore::get()
+{
+    static BlobStore instance;
+    return instance;
+}
+
+
+BlobStore::BlobStore()
+    : mapping(NULL)
+    , mappedSize(0)
+    , indexedSize(0)
+    , garbage(0)
+{
+    open();
+}
+
+
+BlobStore::~BlobStore()
+{
+    sync();
+    if (mapping) {
+        pack.unmap(const_cast<uchar *>(mapping));
+    }
+    pack.close();
+}
+
+
+void BlobStore::open()
+{
+    QString cacheDir = getCacheLocation();
+    QDir().mkpath(cacheDir);
+
+    pack.setFileName(cacheDir + "blobs.pack");
+    indexFileName = cacheDir + "blobs.index";
+
+    bool existed = pack.exists();
+    if (!pack.open(QIODevice::ReadWrite)) {
+        LOG_W(TR("Could not open cache file ") + pack.fileName());
+        return;
+    }
+    map();
+
+    if (!readIndex() || indexedSize > pack.size()) {
+        entries.clear();
+        garbage = 0;
+        scanPack(0);
+    } else if (indexedSize < pack.size()) {
+        // Blobs were written after the index was last saved.
+        scanPack(indexedSize);
+    }
+
+    if (!existed) {
+        importOldCache();
+    }
+
+    if (garbage >= COMPACT_MIN_GARBAGE && garbage * 2 >= pack.size()) {
+        compact();
+    }
+}
+
+
+bool BlobStore::readIndex()
+{
+    recordStartupRead(indexFileName);
+    QFile file(indexFileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic, version, count;
+    in >> magic >> version;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION) {
+        return false;
+    }
+    in >> indexedSize >> garbage >> count;
+
+    entries.clear();
+    entries.reserve(count);
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        QString key;
+        Entry entry;
+        in >> key >> entry.offset >> entry.size;
+        entries.insert(key, entry);
+    }
+
+    return in.status() == QDataStream::Ok;
+}
+
+
+// Reads the record headers from the given offset to the end of the pack.
+// A record that was cut short, e.g. by a crash while writing it, is
+// dropped together with anything after it.
+void BlobStore::scanPack(qint64 from)
+{
+    qint64 offset = from;
+
+    while (offset + HEADER_SIZE <= mappedSize) {
+        QByteArray header = QByteArray::fromRawData((const char *)mapping + offset, HEADER_SIZE);
+        QDataStream in(header);
+        qint32 keySize, dataSize;
+        in >> keySize >> dataSize;
+
+        qint64 recordSize = HEADER_SIZE + keySize + qMax(dataSize, 0);
+        if (keySize <= 0 || dataSize < REMOVED || offset + recordSize > mappedSize) {
+            break;
+        }
+
+        QString key = QString::fromUtf8((const char *)mapping + offset + HEADER_SIZE, keySize);
+        if (entries.contains(key)) {
+            Entry old = entries.value(key);
+            garbage += HEADER_SIZE + keySize + old.size;
+        }
+
+        if (dataSize == REMOVED) {
+            entries.remove(key);
+            garbage += recordSize;
+        } else {
+            Entry entry;
+            entry.offset = offset + HEADER_SIZE + keySize;
+            entry.size = dataSize;
+            entries.insert(key, entry);
+        }
+
+        offset += recordSize;
+    }
+
+    if (offset < pack.size()) {
+        LOG_W(TR("Dropping damaged end of cache file ") + pack.fileName());
+        // Windows doesn't shorten a file that is still mapped.
+        if (mapping) {
+            pack.unmap(const_cast<uchar *>(mapping));
+            mapping = NULL;
+        }
+        if (!pack.resize(offset)) {
+            LOG_W(TR("Could not shorten cache file ") + pack.fileName() + ": "
+                  + pack.errorString());
+        }
+        map();
+    }
+    indexedSize = -1; // Index needs to be written
+}
+
+
+// Moves the per-game directories used by earlier versions into the pack.
+// Those are named after the MD5 of the game; anything else in the cache
+// directory is left alone.
+void BlobStore::importOldCache()
+{
+    QDir cacheDir(getCacheLocation());
+    QStringList games = cacheDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    QRegExp md5("[0-9a-fA-F]{32}");
+
+    foreach (QString game, games) {
+        if (!md5.exactMatch(game)) {
+            continue;
+        }
+
+        QDir gameDir(cacheDir.absoluteFilePath(game));
+        QStringList files;
+        files << "data.json" << "boxart-front.jpg" << "boxart-front.png";
+
+        foreach (QString fileName, files) {
+            QFile file(gameDir.absoluteFilePath(fileName));
+            if (file.open(QIODevice::ReadOnly)) {
+                append(game + "/" + fileName, file.readAll(), false);
+            }
+        }
+
+        gameDir.removeRecursively();
+    }
+
+    sync();
+}
+
+
+// Writes the live blobs to a new pack which then replaces the old one in
+// a single rename. The index is removed first, so if this is interrupted
+// the next open scans whichever pack is in place instead of trusting an
+// index that doesn't match it.
+void BlobStore::compact()
+{
+    if (mappedSize < pack.size()) {
+        map();
+    }
+
+    QSaveFile newPack(pack.fileName());
+    if (!newPack.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QHash<QString, Entry> newEntries;
+    QDataStream out(&newPack);
+    qint64 offset = 0;
+
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        QByteArray key = it.key().toUtf8();
+        out << qint32(key.size()) << qint32(it.value().size);
+        out.writeRawData(key.data(), key.size());
+        out.writeRawData((const char *)mapping + it.value().offset, it.value().size);
+
+        Entry entry;
+        entry.offset = offset + HEADER_SIZE + key.size();
+        entry.size = it.value().size;
+        newEntries.insert(it.key(), entry);
+        offset = entry.offset + entry.size;
+    }
+
+    if (out.status() != QDataStream::Ok) {
+        newPack.cancelWriting();
+        return;
+    }
+
+    QFile::remove(indexFileName);
+
+    pack.unmap(const_cast<uchar *>(mapping));
+    mapping = NULL;
+    pack.close();
+    bool replaced = newPack.commit();
+    if (!pack.open(QIODevice::ReadWrite)) {
+        LOG_W(TR("Could not open cache file ") + pack.fileName());
+    }
+    map();
+
+    if (replaced) {
+        entries = newEntries;
+        garbage = 0;
+    }
+    indexedSize = -1;
+    sync();
+}
+
+
+void BlobStore::map() const
+{
+    if (mapping) {
+        pack.unmap(const_cast<uchar *>(mapping));
+        mapping = NULL;
+    }
+    mappedSize = pack.size();
+    if (mappedSize > 0) {
+        mapping = pack.map(0, mappedSize);
+    }
+    if (!mapping) {
+        mappedSize = 0;
+    }
+}
+
+
+void BlobStore::append(const QString &key, const QByteArray &data, bool removed)
+{
+    if (!pack.isOpen()) {
+        return;
+    }
+
+    QByteArray keyData = key.toUtf8();
+    qint32 dataSize = removed ? REMOVED : data.size();
+
+    pack.seek(pack.size());
+    QDataStream out(&pack);
+    out << qint32(keyData.size()) << dataSize;
+    out.writeRawData(keyData.data(), keyData.size());
+    if (!removed) {
+        out.writeRawData(data.data(), data.size());
+    }
+    pack.flush();
+
+    if (entries.contains(key)) {
+        garbage += HEADER_SIZE + keyData.size() + entries.value(key).size;
+    }
+
+    if (removed) {
+        entries.remove(key);
+        garbage += HEADER_SIZE + keyData.size();
+    } else {
+        Entry entry;
+        entry.offset = pack.size() - data.size();
+        entry.size = data.size();
+        entries.insert(key, entry);
+    }
+
+    indexedSize = -1;
+}
+
+
+bool BlobStore::contains(const QString &key) const
+{
+    return entries.contains(key);
+}
+
+
+QByteArray BlobStore::read(const QString &key) const
+{
+    if (!entries.contains(key)) {
+        return QByteArray();
+    }
+    Entry entry = entries.value(key);
+    if (entry.offset + entry.size > mappedSize) {
+        map();
+        if (entry.offset + entry.size > mappedSize) {
+            return QByteArray();
+        }
+    }
+    recordStartupRead(pack.fileName(), entry.offset, entry.size);
+    return QByteArray((const char *)mapping + entry.offset, entry.size);
+}
+
+
+void BlobStore::write(const QString &key, const QByteArray &data)
+{
+    append(key, data, false);
+}
+
+
+void BlobStore::remove(const QString &key)
+{
+    if (entries.contains(key)) {
+        append(key, QByteArray(), true);
+    }
+}
+
+
+void BlobStore::sync()
+{
+    if (!pack.isOpen() || indexedSize == pack.size()) {
+        return;
+    }
+
+    QSaveFile file(indexFileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream out(&file);
+    out << quint32(INDEX_MAGIC) << quint32(INDEX_VERSION)
+        << qint64(pack.size()) << garbage << quint32(entries.size());
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        out << it.key() << it.value().offset << it.value().size;
+    }
+
+    if (file.commit()) {
+        indexedSize = pack.size();
+    }
+}
@@ -0,0 +1,94 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#ifndef BLOBSTORE_H
+#define BLOBSTORE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+// Stores the scraped game information and cover images in one pack file
+// instead of one directory per game. Blobs are only ever appended to the
+// pack; replacing or removing a blob makes the old copy garbage, which is
+// dropped when the pack is compacted on open. The offsets of the live
+// blobs are kept in an index file next to the pack, so opening the store
+// reads two files and the blobs are then read from a memory mapping.
+//
+// Keys look like the old cache paths, e.g. "<md5>/data.json".
+// The store is only used from the main thread.
+class BlobStore
+{
+public:
+    static BlobStore &get();
+
+    bool contains(const QString &key) const;
+    QByteArray read(const QString &key) const;
+    void write(const QString &key, const QByteArray &data);
+    void remove(const QString &key);
+
+    // Writes the index so the next start doesn't have to scan the pack.
+    void sync();
+
+private:
+    struct Entry {
+        qint64 offset;
+        qint64 size;
+    };
+
+    BlobStore();
+    ~BlobStore();
+    BlobStore(const BlobStore &other);
+    BlobStore &operator=(const BlobStore &other);
+
+    void open();
+    bool readIndex();
+    void scanPack(qint64 from);
+    void importOldCache();
+    void compact();
+    void append(const QString &key, const QByteArray &data, bool removed);
+    // Maps the whole pack again. Appending doesn't, so read() calls this
+    // when a blob lies past the end of the mapping.
+    void map() const;
+
+    mutable QFile pack;
+    QString indexFileName;
+    mutable const uchar *mapping;
+    mutable qint64 mappedSize;
+
+    QHash<QString, Entry> entries;
+    qint64 indexedSize;
+    qint64 garbage;
+};
+
+#endif // BLOBSTORE_H
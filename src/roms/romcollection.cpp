@@ -33,20 +33,66 @@
 #include "../error.h"
 #include "../global.h"
 #include "../common.h"
+#include "../prefetch.h"
 
+#include "blobstore.h"
+#include "scanstats.h"
 #include "thegamesdbscraper.h"
 
 #include <QCoreApplication>
 #include <QCryptographicHash>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QProgressDialog>
-#include <QTime>
 
 #include <QtSql/QSqlQuery>
 
 
+// A ROM found while scanning, remembered so that other links to the same
+// file can reuse it without reading the file again.
+struct ScannedRom {
+    Rom rom;
+    bool ddRom;
+};
+
+
+// Reads every page of a mapped file so the time spent waiting for the
+// disk isn't counted as hashing.
+static void touchPages(const char *data, qint64 size)
+{
+    volatile char sum = 0;
+    for (qint64 i = 0; i < size; i += 4096)
+        sum += data[i];
+}
+
+
+static QString getRomLocation(const Rom &rom)
+{
+    QDir dir(rom.directory);
+    if (rom.zipFile == "")
+        return dir.absoluteFilePath(rom.fileName);
+    return dir.absoluteFilePath(rom.zipFile) + "/" + rom.fileName;
+}
+
+
+// Adds the ROM to the list unless a ROM with the same MD5 is already in
+// it, in which case only its location is added to that ROM.
+static void addUniqueRom(QList<Rom> &roms, QHash<QString, int> &index, const Rom &rom)
+{
+    QString md5 = rom.romMD5.toUpper();
+
+    if (index.contains(md5)) {
+        roms[index.value(md5)].alternateLocations << getRomLocation(rom);
+    } else {
+        index.insert(md5, roms.size());
+        roms.append(rom);
+    }
+}
+
+
 RomCollection::RomCollection(QStringList fileTypes, QStringList romPaths, QWidget *parent)
     : QObject(parent)
 {
@@ -54,6 +100,7 @@ RomCollection::RomCollection(QStringList fileTypes, QStringList romPaths, QWidge
     this->romPaths = romPaths;
     this->romPaths.removeAll("");
     this->parent = parent;
+    this->stats = 0;
 
     setupDatabase();
 }
@@ -72,11 +119,22 @@ Rom RomCollection::addRom(QByteArray *romData, QString fileName, QString directo
     else
         currentRom.internalName = QString(romData->mid(32, 20)).trimmed();
 
+    stats->start(STAGE_HASHING);
     currentRom.romMD5 = QString(QCryptographicHash::hash(*romData,
                                 QCryptographicHash::Md5).toHex());
+    stats->stop(romData->size());
+
     currentRom.zipFile = zipFile;
     currentRom.sortSize = romData->size();
 
+    storeRom(currentRom, query, ddRom);
+
+    return currentRom;
+}
+
+
+void RomCollection::storeRom(const Rom &currentRom, QSqlQuery query, bool ddRom)
+{
     query.bindValue(":filename",      currentRom.fileName);
     query.bindValue(":directory",     currentRom.directory);
     query.bindValue(":internal_name", currentRom.internalName);
@@ -89,12 +147,9 @@ Rom RomCollection::addRom(QByteArray *romData, QString fileName, QString directo
     else
         query.bindValue(":dd_rom", 0);
 
+    stats->start(STAGE_DATABASE);
     query.exec();
-
-    if (!ddRom)
-        initializeRom(&currentRom, false);
-
-    return currentRom;
+    stats->stop();
 }
 
 
@@ -104,18 +159,26 @@ int RomCollection::addRoms()
 
     //Count files so we know how to setup the progress dialog
     int totalCount = 0;
+    QHash<QString, QStringList> romFiles;
+    QElapsedTimer listTimer;
+    listTimer.start();
 
     foreach (QString romPath, romPaths) {
         QDir romDir(romPath);
 
         if (romDir.exists()) {
             QStringList files = scanDirectory(romDir);
+            romFiles.insert(romPath, files);
             totalCount += files.size();
         }
     }
 
-    QList<Rom> roms;
-    QList<Rom> ddRoms;
+    ScanStats scanStats(totalCount);
+    scanStats.add(STAGE_LISTING, listTimer.nsecsElapsed(), 0, totalCount);
+    stats = &scanStats;
+
+    roms.clear();
+    ddRoms.clear();
 
     database.open();
     database.transaction();
@@ -131,10 +194,21 @@ int RomCollection::addRoms()
 
         scraper = new TheGamesDBScraper(parent);
 
+        // ROMs found in each file, by storage key, so hard links and
+        // reflinks of a file that was already scanned are not read again.
+        QHash<QString, QList<ScannedRom> > scannedFiles;
+        // Where copies of each MD5 are stored, to find duplicates.
+        QHash<QString, QStringList> copies;
+        QHash<QString, int> romIndex, ddRomIndex;
+        int duplicates = 0;
+        qint64 reclaimable = 0;
+        QElapsedTimer progressTimer;
+        progressTimer.start();
+
         foreach (QString romPath, romPaths)
         {
             QDir romDir(romPath);
-            QStringList files = scanDirectory(romDir);
+            QStringList files = romFiles.value(romPath);
 
             int romCount = 0;
 
@@ -142,44 +216,105 @@ int RomCollection::addRoms()
             {
                 QString completeFileName = romDir.absoluteFilePath(fileName);
                 QFile file(completeFileName);
+                bool isZip = QFileInfo(file).suffix().toLower() == "zip";
+                QString storageKey = getStorageKey(completeFileName);
+                QList<ScannedRom> found;
 
-                //If file is a zip file, extract info from any zipped ROMs
-                if (QFileInfo(file).suffix().toLower() == "zip") {
+                if (storageKey != "" && scannedFiles.contains(storageKey)) {
+                    //Same data as a file that was already scanned, reuse it
+                    foreach (ScannedRom scanned, scannedFiles.value(storageKey))
+                    {
+                        if (isZip)
+                            scanned.rom.zipFile = fileName;
+                        else
+                            scanned.rom.fileName = fileName;
+                        scanned.rom.directory = romPath;
+                        scanned.rom.baseName = QFileInfo(scanned.rom.fileName).completeBaseName();
+                        scanned.rom.alternateLocations.clear();
+
+                        storeRom(scanned.rom, query, scanned.ddRom);
+                        found << scanned;
+                    }
+                } else if (isZip) {
+                    //If file is a zip file, extract info from any zipped ROMs
                     foreach (QString zippedFile, getZippedFiles(completeFileName))
                     {
                         //check for ROM files
                         QByteArray romData;
+                        scanStats.start(STAGE_DECOMPRESSING);
                         readRomFile(romData, zippedFile, completeFileName);
+                        scanStats.stop(romData.size());
 
                         if (fileTypes.contains("*.v64"))
                             byteswap(romData);
 
                         if (romData.left(4).toHex() == "80371240") { //Z64 ROM
-                            roms.append(addRom(&romData, zippedFile, romPath, fileName, query));
-                            romCount++;
+                            ScannedRom scanned = {addRom(&romData, zippedFile, romPath, fileName, query), false};
+                            found << scanned;
                         } else if (romData.left(4).toHex() == "e848d316") { //64DD ROM
-                            ddRoms.append(addRom(&romData, zippedFile, romPath, fileName, query, true));
-                            romCount++;
+                            ScannedRom scanned = {addRom(&romData, zippedFile, romPath, fileName, query, true), true};
+                            found << scanned;
                         }
                     }
                 } else { //Just a normal file
                     QByteArray romData;
-                    romData = QByteArray::fromRawData(mapFile(file), file.size());
+                    scanStats.start(STAGE_READING);
+                    const char *mapped = mapFile(file);
+                    if (mapped)
+                        touchPages(mapped, file.size());
+                    scanStats.stop(file.size());
+                    romData = QByteArray::fromRawData(mapped, file.size());
 
                     if (fileTypes.contains("*.v64"))
                         byteswap(romData);
 
                     if (romData.left(4).toHex() == "80371240") { //Z64 ROM
-                        roms.append(addRom(&romData, fileName, romPath, "", query));
-                        romCount++;
+                        ScannedRom scanned = {addRom(&romData, fileName, romPath, "", query), false};
+                        found << scanned;
                     } else if (romData.left(4).toHex() == "e848d316") { //64DD ROM
-                        ddRoms.append(addRom(&romData, fileName, romPath, "", query, true));
-                        romCount++;
+                        ScannedRom scanned = {addRom(&romData, fileName, romPath, "", query, true), true};
+                        found << scanned;
+                    }
+                }
+
+                if (storageKey != "" && !scannedFiles.contains(storageKey))
+                    scannedFiles.insert(storageKey, found);
+
+                foreach (ScannedRom scanned, found)
+                {
+                    //Copies of a ROM that was already added only add a location
+                    if (scanned.ddRom)
+                        addUniqueRom(ddRoms, ddRomIndex, scanned.rom);
+                    else if (!romIndex.contains(scanned.rom.romMD5.toUpper())) {
+                        scanStats.start(STAGE_SCRAPING);
+                        initializeRom(&scanned.rom, false);
+                        scanStats.stop();
+                        addUniqueRom(roms, romIndex, scanned.rom);
+                    } else
+                        addUniqueRom(roms, romIndex, scanned.rom);
+                    romCount++;
+
+                    //Removing a copy only frees space if its data isn't shared
+                    //with another copy. Only count unzipped copies since the
+                    //space used by a ROM inside a ZIP file isn't known.
+                    QString location = storageKey != "" ? storageKey : completeFileName;
+                    QStringList &locations = copies[scanned.rom.romMD5.toUpper()];
+                    if (!locations.isEmpty()) {
+                        duplicates++;
+                        if (!isZip && !locations.contains(location))
+                            reclaimable += file.size();
                     }
+                    if (!locations.contains(location))
+                        locations << location;
                 }
 
                 count++;
+                scanStats.fileDone();
                 progress->setValue(count);
+                if (progressTimer.elapsed() >= 250) {
+                    progress->setLabelText(scanStats.progressText());
+                    progressTimer.restart();
+                }
                 QCoreApplication::processEvents(QEventLoop::AllEvents);
             }
 
@@ -187,15 +322,26 @@ int RomCollection::addRoms()
                 SHOW_W(tr("No ROMs found in ") + romPath + ".");
         }
 
+        if (duplicates > 0)
+            LOG_I(tr("Found %1 duplicate ROMs, removing them would free %2 MB.")
+                  .arg(duplicates).arg(reclaimable / 1024 / 1024));
+
         delete scraper;
+        BlobStore::get().sync();
         progress->close();
     } else if (romPaths.size() != 0) {
         SHOW_W(tr("No ROMs found."));
     }
 
+    scanStats.start(STAGE_DATABASE);
     database.commit();
+    scanStats.stop();
     database.close();
 
+    if (totalCount != 0)
+        scanStats.log();
+    stats = 0;
+
     //Emit signals for regular roms
     qSort(roms.begin(), roms.end(), romSorter);
 
@@ -243,12 +389,13 @@ int RomCollection::cachedRoms(bool imageUpdated, bool onStartup)
     }
 
 
-    QList<Rom> roms;
-    QList<Rom> ddRoms;
+    roms.clear();
+    ddRoms.clear();
+    QHash<QString, int> romIndex, ddRomIndex;
 
     int count = 0;
     bool showProgress = false;
-    QTime checkPerformance;
+    ScanStats loadStats(romCount);
 
     while (query.next())
     {
@@ -262,28 +409,26 @@ int RomCollection::cachedRoms(bool imageUpdated, bool onStartup)
         currentRom.sortSize = query.value(5).toInt();
         int ddRom = query.value(6).toInt();
 
-        //Check performance of adding first item to see if progress dialog needs to be shown
-        if (count == 0) checkPerformance.start();
-
+        //Copies of a ROM that was already loaded only add a location
         if (ddRom == 1)
-            ddRoms.append(currentRom);
-        else {
+            addUniqueRom(ddRoms, ddRomIndex, currentRom);
+        else if (!romIndex.contains(currentRom.romMD5.toUpper())) {
+            loadStats.start(STAGE_SCRAPING);
             initializeRom(&currentRom, true);
-            roms.append(currentRom);
-        }
+            loadStats.stop();
+            addUniqueRom(roms, romIndex, currentRom);
+        } else
+            addUniqueRom(roms, romIndex, currentRom);
 
-        if (count == 0) {
-            int runtime = checkPerformance.elapsed();
+        count++;
+        loadStats.fileDone();
 
-            //check if operation expected to take longer than two seconds
-            if (runtime * romCount > 2000) {
-                setupProgressDialog(romCount);
-                showProgress = true;
-            }
+        //Show progress once the rest is expected to take longer than two seconds
+        if (!showProgress && loadStats.secondsLeft() > 2) {
+            setupProgressDialog(romCount);
+            showProgress = true;
         }
 
-        count++;
-
         if (showProgress) {
             progress->setValue(count);
             QCoreApplication::processEvents(QEventLoop::AllEvents);
@@ -313,6 +458,12 @@ int RomCollection::cachedRoms(bool imageUpdated, bool onStartup)
 }
 
 
+const QList<Rom> &RomCollection::getRoms() const
+{
+    return roms;
+}
+
+
 QStringList RomCollection::getFileTypes(bool archives)
 {
     QStringList returnList = fileTypes;
@@ -337,6 +488,7 @@ void RomCollection::initializeRom(Rom *currentRom, bool cached)
             catalogFile = dataDir.absoluteFilePath("mupen64plus.ini");
     }
 
+    recordStartupRead(catalogFile);
     QDir romDir(currentRom->directory);
 
     //Default text for GoodName to notify user
@@ -391,14 +543,10 @@ void RomCollection::initializeRom(Rom *currentRom, bool cached)
     }
 
     if (SETTINGS.value("Other/downloadinfo", "").toString() == "true") {
-        QString dataFile = getCacheLocation() + currentRom->romMD5.toLower() + "/data.json";
-        QFile file(dataFile);
-
-        file.open(QIODevice::ReadOnly);
-        QString data = file.readAll();
-        file.close();
+        BlobStore &store = BlobStore::get();
+        QString gameCache = currentRom->romMD5.toLower();
 
-        QJsonDocument document = QJsonDocument::fromJson(data.toUtf8());
+        QJsonDocument document = QJsonDocument::fromJson(store.read(gameCache + "/data.json"));
         QJsonObject json = document.object();
 
         //Remove any non-standard characters
@@ -420,10 +568,9 @@ void RomCollection::initializeRom(Rom *currentRom, bool cached)
 
         foreach (QString ext, QStringList() << "jpg" << "png")
         {
-            QString imageFile = getCacheLocation() + currentRom->romMD5.toLower() + "/boxart-front." + ext;
-            QFile cover(imageFile);
+            QByteArray imageData = store.read(gameCache + "/boxart-front." + ext);
 
-            if (cover.exists() && currentRom->image.load(imageFile)) {
+            if (!imageData.isEmpty() && currentRom->image.loadFromData(imageData)) {
                 currentRom->imageExists = true;
                 break;
             }
@@ -456,6 +603,7 @@ void RomCollection::setupDatabase()
 
     database = QSqlDatabase::addDatabase("QSQLITE");
     database.setDatabaseName(getDataLocation() + "/"+AppNameLower+".sqlite");
+    recordStartupRead(database.databaseName());
 
     if (!database.open()) {
         SHOW_W(tr("Could not connect to Sqlite database. Application may misbehave."));
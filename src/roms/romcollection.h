@@ -32,14 +32,17 @@
 #ifndef ROMCOLLECTION_H
 #define ROMCOLLECTION_H
 
+#include "../common.h"
+
+#include <QList>
 #include <QObject>
 #include <QStringList>
 #include <QtSql/QSqlDatabase>
 
 class QDir;
 class QProgressDialog;
+class ScanStats;
 class TheGamesDBScraper;
-struct Rom;
 
 
 class RomCollection : public QObject
@@ -50,6 +53,10 @@ public:
     int cachedRoms(bool imageUpdated = false, bool onStartup = false);
     void updatePaths(QStringList romPaths);
 
+    // The sorted ROMs from the last scan or cache load. All views are
+    // built from this list so they don't have to go through the database.
+    const QList<Rom> &getRoms() const;
+
     QStringList getFileTypes(bool archives = false);
     QStringList romPaths;
 
@@ -69,6 +76,7 @@ private:
 
     Rom addRom(QByteArray *romData, QString fileName, QString directory, QString zipFile, QSqlQuery query,
                bool ddRom = false);
+    void storeRom(const Rom &currentRom, QSqlQuery query, bool ddRom);
 
     QStringList fileTypes;
     QStringList scanDirectory(QDir romDir);
@@ -77,7 +85,13 @@ private:
     QProgressDialog *progress;
     QSqlDatabase database;
 
+    QList<Rom> roms;
+    QList<Rom> ddRoms;
+
     TheGamesDBScraper *scraper;
+
+    // Set while addRoms() runs
+    ScanStats *stats;
 };
 
 #endif // ROMCOLLECTION_H
@@ -0,0 +1,168 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#include "scanstats.h"
+#include "../error.h"
+#include "../common.h"
+
+#include <QStringList>
+
+// Number of files the remaining time is estimated from.
+#define WINDOW_SIZE 32
+
+static const char *stageNames[STAGE_COUNT] = {
+    QT_TR_NOOP("Listing"),
+    QT_TR_NOOP("Reading"),
+    QT_TR_NOOP("Decompressing"),
+    QT_TR_NOOP("Hashing"),
+    QT_TR_NOOP("Database"),
+    QT_TR_NOOP("Game info"),
+};
+
+
+static QString formatDuration(int seconds)
+{
+    if (seconds < 60)
+        return TR("%1 s").arg(seconds);
+    return TR("%1 min %2 s").arg(seconds / 60).arg(seconds % 60);
+}
+
+
+ScanStats::ScanStats(int totalFiles)
+    : currentStage(STAGE_COUNT)
+    , stageStart(0)
+    , totalFiles(totalFiles)
+    , doneFiles(0)
+{
+    for (int i = 0; i < STAGE_COUNT; i++)
+        stages[i] = {0, 0, 0};
+
+    clock.start();
+    window.enqueue(0);
+}
+
+
+void ScanStats::start(ScanStage stage)
+{
+    currentStage = stage;
+    stageStart = clock.nsecsElapsed();
+}
+
+
+void ScanStats::stop(qint64 bytes)
+{
+    if (currentStage == STAGE_COUNT)
+        return;
+
+    add(currentStage, clock.nsecsElapsed() - stageStart, bytes, 1);
+    currentStage = STAGE_COUNT;
+}
+
+
+void ScanStats::add(ScanStage stage, qint64 nsecs, qint64 bytes, int items)
+{
+    stages[stage].nsecs += nsecs;
+    stages[stage].bytes += bytes;
+    stages[stage].items += items;
+}
+
+
+void ScanStats::fileDone()
+{
+    doneFiles++;
+    window.enqueue(clock.nsecsElapsed());
+    if (window.size() > WINDOW_SIZE)
+        window.dequeue();
+}
+
+
+int ScanStats::secondsLeft() const
+{
+    if (window.size() < 2)
+        return -1;
+
+    double nsecsPerFile = double(window.last() - window.first()) / (window.size() - 1);
+    return qRound(nsecsPerFile * (totalFiles - doneFiles) / 1e9);
+}
+
+
+QString ScanStats::stageText(int stage) const
+{
+    const Stage &s = stages[stage];
+    double seconds = s.nsecs / 1e9;
+
+    QString text = TR(stageNames[stage]) + ": ";
+    if (s.bytes > 0 && seconds > 0)
+        text += TR("%1 MB/s, ").arg(s.bytes / seconds / 1024 / 1024, 0, 'f', 1);
+    if (seconds > 0)
+        text += TR("%1 files/s, ").arg(s.items / seconds, 0, 'f', 1);
+    text += TR("%1 s").arg(seconds, 0, 'f', 2);
+    return text;
+}
+
+
+QString ScanStats::progressText() const
+{
+    QString text = TR("%1 of %2 files").arg(doneFiles).arg(totalFiles);
+    int left = secondsLeft();
+    if (left >= 0)
+        text += ", " + TR("about %1 left").arg(formatDuration(left));
+
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        if (stages[i].items > 0)
+            text += "\n" + stageText(i);
+    }
+    return text;
+}
+
+
+void ScanStats::log() const
+{
+    int slowest = 0;
+    qint64 bytes = 0;
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        if (stages[i].nsecs > stages[slowest].nsecs)
+            slowest = i;
+        bytes = qMax(bytes, stages[i].bytes);
+    }
+
+    LOG_I(TR("Scanned %1 files (%2 MB) in %3, most of the time went to %4.")
+          .arg(doneFiles)
+          .arg(bytes / 1024 / 1024)
+          .arg(formatDuration(qRound(clock.nsecsElapsed() / 1e9)))
+          .arg(TR(stageNames[slowest]).toLower()));
+
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        if (stages[i].items > 0)
+            LOG_I(stageText(i));
+    }
+}
@@ -0,0 +1,94 @@
+/***
+ * Copyright (c) 2018, Robert Alm Nilsson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the organization nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+
+
+#ifndef SCANSTATS_H
+#define SCANSTATS_H
+
+#include <QElapsedTimer>
+#include <QQueue>
+#include <QString>
+
+enum ScanStage {
+    STAGE_LISTING,
+    STAGE_READING,
+    STAGE_DECOMPRESSING,
+    STAGE_HASHING,
+    STAGE_DATABASE,
+    STAGE_SCRAPING,
+    STAGE_COUNT
+};
+
+
+// Keeps track of where the time goes while ROMs are scanned, to show the
+// throughput of each stage and estimate how long the rest will take. The
+// estimate is based on how fast the last few files went, so it follows
+// along when e.g. a slow network drive is reached.
+class ScanStats
+{
+public:
+    explicit ScanStats(int totalFiles);
+
+    // Times the work between start() and stop() as part of the stage.
+    // Stages don't nest.
+    void start(ScanStage stage);
+    void stop(qint64 bytes = 0);
+    void add(ScanStage stage, qint64 nsecs, qint64 bytes, int items);
+
+    void fileDone();
+
+    // Estimated seconds left, -1 if not known yet.
+    int secondsLeft() const;
+
+    QString progressText() const;
+    void log() const;
+
+private:
+    struct Stage {
+        qint64 nsecs;
+        qint64 bytes;
+        int items;
+    };
+
+    QString stageText(int stage) const;
+
+    Stage stages[STAGE_COUNT];
+    ScanStage currentStage;
+    qint64 stageStart;
+    QElapsedTimer clock;
+
+    int totalFiles;
+    int doneFiles;
+    // When the last few files were done, in nanoseconds since the start.
+    QQueue<qint64> window;
+};
+
+#endif // SCANSTATS_H
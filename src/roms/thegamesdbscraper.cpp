@@ -30,6 +30,7 @@
  ***/
 
 #include "thegamesdbscraper.h"
+#include "blobstore.h"
 
 #include "../global.h"
 #include "../common.h"
@@ -40,7 +41,6 @@
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QMessageBox>
-#include <QTextStream>
 #include <QTimer>
 #include <QUrl>
 
@@ -115,32 +115,16 @@ void TheGamesDBScraper::deleteGameInfo(QString fileName, QString identifier)
                                        QMessageBox::Yes | QMessageBox::No);
 
     if (answer == QMessageBox::Yes) {
-        QString gameCache = getCacheLocation() + identifier.toLower();
-
-        QString dataFile = gameCache + "/data.xml";
-        QFile file(dataFile);
+        QString gameCache = identifier.toLower();
+        BlobStore &store = BlobStore::get();
 
         // Remove game information
-        file.open(QIODevice::WriteOnly);
-        QTextStream stream(&file);
-        stream << "NULL";
-        file.close();
-
-        // Remove cover image
-        QString coverFile = gameCache + "/boxart-front.";
+        store.write(gameCache + "/data.json", "NULL");
 
-        QFile coverJPG(coverFile + "jpg");
-        QFile coverPNG(coverFile + "png");
-
-        if (coverJPG.exists())
-            coverJPG.remove();
-        if (coverPNG.exists())
-            coverPNG.remove();
-
-        coverJPG.open(QIODevice::WriteOnly);
-        QTextStream streamImage(&coverJPG);
-        streamImage << "";
-        coverJPG.close();
+        // Remove cover image, leaving an empty one so it isn't downloaded again
+        store.remove(gameCache + "/boxart-front.png");
+        store.write(gameCache + "/boxart-front.jpg", QByteArray());
+        store.sync();
     }
 }
 
@@ -152,11 +136,12 @@ void TheGamesDBScraper::downloadGameInfo(QString identifier, QString searchName,
 
         bool updated = false;
 
-        QString gameCache = getCacheLocation() + identifier.toLower();
-        QDir cache(gameCache);
+        QString gameCache = identifier.toLower();
+        BlobStore &store = BlobStore::get();
 
+        QDir cache(getCacheLocation());
         if (!cache.exists()) {
-            cache.mkpath(gameCache);
+            cache.mkpath(getCacheLocation());
         }
 
         QFile genres(getCacheLocation() + "genres.json");
@@ -173,9 +158,8 @@ void TheGamesDBScraper::downloadGameInfo(QString identifier, QString searchName,
 
         //Get game JSON info from thegamesdb.net
         QString dataFile = gameCache + "/data.json";
-        QFile file(dataFile);
 
-        if (!file.exists() || file.size() == 0 || force) {
+        if (store.read(dataFile).isEmpty() || force) {
             QUrl url;
 
             //Remove [!], (U), etc. from GoodName for searching
@@ -306,9 +290,7 @@ void TheGamesDBScraper::downloadGameInfo(QString identifier, QString searchName,
 
                 QJsonDocument document(saveData);
 
-                file.open(QIODevice::WriteOnly);
-                file.write(document.toJson());
-                file.close();
+                store.write(dataFile, document.toJson());
             }
 
             if (force && !updated) {
@@ -329,15 +311,8 @@ void TheGamesDBScraper::downloadGameInfo(QString identifier, QString searchName,
         QString boxartExt = "";
         QString coverFile = gameCache + "/boxart-front.";
 
-        QFile coverJPG(coverFile + "jpg");
-        QFile coverPNG(coverFile + "png");
-
-        if ((!coverJPG.exists() && !coverPNG.exists()) || (force && updated)) {
-            file.open(QIODevice::ReadOnly);
-            QString data = file.readAll();
-            file.close();
-
-            QJsonDocument document = QJsonDocument::fromJson(data.toUtf8());
+        if ((!store.contains(coverFile + "jpg") && !store.contains(coverFile + "png")) || (force && updated)) {
+            QJsonDocument document = QJsonDocument::fromJson(store.read(dataFile));
             QJsonObject json = document.object();
             QString boxartURL = json.value("boxart").toString();
 
@@ -345,19 +320,19 @@ void TheGamesDBScraper::downloadGameInfo(QString identifier, QString searchName,
                 QUrl url(boxartURL);
 
                 // Delete current box art
-                QFile::remove(coverFile + "jpg");
-                QFile::remove(coverFile + "png");
+                store.remove(coverFile + "jpg");
+                store.remove(coverFile + "png");
 
                 // Check to save as JPG or PNG
                 boxartExt = QFileInfo(boxartURL).completeSuffix().toLower();
-                QFile cover(coverFile + boxartExt);
-
-                cover.open(QIODevice::WriteOnly);
-                cover.write(getUrlContents(url));
-                cover.close();
+                store.write(coverFile + boxartExt, getUrlContents(url));
             }
         }
 
+        if (force) {
+            store.sync();
+        }
+
         if (updated) {
             QMessageBox::information(parent, QObject::tr("Game Information Download"),
                                      QObject::tr("Download Complete!"));
@@ -31,9 +31,23 @@
 
 #include "settings.h"
 #include "global.h"
+#include "common.h"
+#include "error.h"
 #include "osal/osal_preproc.h"
 
 #include <QDir>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVariant>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+
+
+// Cache of the game_settings table. It is read from the emulation thread
+// when plugins are attached, so it is protected by a mutex.
+static QHash<QString, GameSettings> gameSettings;
+static QMutex gameSettingsMutex;
 
 
 static QDir getPluginPath()
@@ -62,13 +76,17 @@ QStringList getAvailableVideoPlugins()
 
 QStringList getAvailableAudioPlugins()
 {
-    return getAvailablePluginsMatching("mupen64plus-audio-*");
+    return getAvailablePluginsMatching("mupen64plus-audio-*") << NullPlugin;
 }
 
 
 QStringList getAvailableInputPlugins()
 {
-    return getAvailablePluginsMatching("mupen64plus-input-*");
+    // The script plugin is listed under its built-in name even if its
+    // library was copied to the plugin directory.
+    QStringList plugins = getAvailablePluginsMatching("mupen64plus-input-*");
+    plugins.removeAll(ScriptPluginLibrary);
+    return plugins << NullPlugin << ScriptPlugin;
 }
 
 
@@ -78,12 +96,18 @@ QStringList getAvailableRspPlugins()
 }
 
 
+bool isBuiltinPlugin(const QString &name)
+{
+    return name == NullPlugin || name == ScriptPlugin;
+}
+
+
 QString getCurrentVideoPlugin(QString game)
 {
     QString plugin;
     QString defaultName = "mupen64plus-video-glide64mk2";
     if (game != "") {
-        plugin = SETTINGS.value(game + "/video", "").toString();
+        plugin = getGameSettings(game).video;
     }
     if (plugin == "") {
         plugin = SETTINGS.value("Plugins/video", defaultName).toString();
@@ -96,7 +120,7 @@ QString getCurrentAudioPlugin(QString game)
 {
     QString plugin;
     if (game != "") {
-        plugin = SETTINGS.value(game + "/audio", "").toString();
+        plugin = getGameSettings(game).audio;
     }
     if (plugin == "") {
         plugin = SETTINGS.value("Plugins/audio", "").toString();
@@ -109,7 +133,7 @@ QString getCurrentInputPlugin(QString game)
 {
     QString plugin;
     if (game != "") {
-        plugin = SETTINGS.value(game + "/input", "").toString();
+        plugin = getGameSettings(game).input;
     }
     if (plugin == "") {
         plugin = SETTINGS.value("Plugins/input", "").toString();
@@ -122,10 +146,133 @@ QString getCurrentRspPlugin(QString game)
 {
     QString plugin;
     if (game != "") {
-        plugin = SETTINGS.value(game + "/rsp", "").toString();
+        plugin = getGameSettings(game).rsp;
     }
     if (plugin == "") {
         plugin = SETTINGS.value("Plugins/rsp", "").toString();
     }
     return plugin;
 }
+
+
+bool GameSettings::isEmpty() const
+{
+    return video == "" && audio == "" && input == ""
+        && rsp == "" && config == "";
+}
+
+
+void loadGameSettings()
+{
+    QSqlDatabase database = QSqlDatabase::database();
+
+    database.exec(QString()
+                    + "CREATE TABLE IF NOT EXISTS game_settings ("
+                        + "md5 TEXT PRIMARY KEY NOT NULL, "
+                        + "video TEXT, "
+                        + "audio TEXT, "
+                        + "input TEXT, "
+                        + "rsp TEXT, "
+                        + "config TEXT)");
+
+    QSqlQuery query("SELECT md5, video, audio, input, rsp, config "
+                    "FROM game_settings", database);
+
+    QMutexLocker locker(&gameSettingsMutex);
+    gameSettings.clear();
+
+    while (query.next()) {
+        GameSettings settings;
+        settings.video = query.value(1).toString();
+        settings.audio = query.value(2).toString();
+        settings.input = query.value(3).toString();
+        settings.rsp = query.value(4).toString();
+        settings.config = query.value(5).toString();
+        gameSettings.insert(query.value(0).toString(), settings);
+    }
+}
+
+
+GameSettings getGameSettings(const QString &md5)
+{
+    QMutexLocker locker(&gameSettingsMutex);
+    return gameSettings.value(md5.toUpper());
+}
+
+
+void setGameSettings(const QString &md5, const GameSettings &settings)
+{
+    QString key = md5.toUpper();
+    QSqlDatabase database = QSqlDatabase::database();
+    QSqlQuery query(database);
+
+    if (settings.isEmpty()) {
+        query.prepare("DELETE FROM game_settings WHERE md5 = :md5");
+        query.bindValue(":md5", key);
+    } else {
+        query.prepare(QString("INSERT OR REPLACE INTO game_settings ")
+                      + "(md5, video, audio, input, rsp, config) "
+                      + "VALUES (:md5, :video, :audio, :input, :rsp, :config)");
+        query.bindValue(":md5",    key);
+        query.bindValue(":video",  settings.video);
+        query.bindValue(":audio",  settings.audio);
+        query.bindValue(":input",  settings.input);
+        query.bindValue(":rsp",    settings.rsp);
+        query.bindValue(":config", settings.config);
+    }
+
+    if (!query.exec()) {
+        LOG_W(TR("Could not save game settings for <MD5>.")
+                .replace("<MD5>", key));
+    }
+
+    QMutexLocker locker(&gameSettingsMutex);
+    if (settings.isEmpty()) {
+        gameSettings.remove(key);
+    } else {
+        gameSettings.insert(key, settings);
+    }
+}
+
+
+// Moves one old INI group to the game's settings, unless the game
+// already has settings of its own.
+static void migrateGameGroup(const QString &group, const QString &md5)
+{
+    GameSettings game;
+    game.video = SETTINGS.value(group + "/video", "").toString();
+    game.audio = SETTINGS.value(group + "/audio", "").toString();
+    game.input = SETTINGS.value(group + "/input", "").toString();
+    game.rsp = SETTINGS.value(group + "/rsp", "").toString();
+    game.config = SETTINGS.value(group + "/config", "").toString();
+
+    if (!game.isEmpty() && getGameSettings(md5).isEmpty()) {
+        setGameSettings(md5, game);
+    }
+    SETTINGS.remove(group);
+}
+
+
+void migrateGameSettings(const QList<Rom> &roms)
+{
+    QStringList groups = SETTINGS.childGroups();
+
+    foreach (const Rom &rom, roms) {
+        if (groups.contains(rom.fileName)) {
+            migrateGameGroup(rom.fileName, rom.romMD5);
+            groups.removeOne(rom.fileName);
+        }
+
+        // Copies with the same MD5 only leave their location behind, and
+        // their group was named after the file name at the end of it.
+        foreach (const QString &location, rom.alternateLocations) {
+            foreach (const QString &group, groups) {
+                if (location.endsWith("/" + group)) {
+                    migrateGameGroup(group, rom.romMD5);
+                    groups.removeOne(group);
+                    break;
+                }
+            }
+        }
+    }
+}
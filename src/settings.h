@@ -35,6 +35,36 @@
 #include <QString>
 #include <QStringList>
 
+struct Rom;
+
+
+// Name of the plugin that is built into the frontend for audio and input.
+// When it is selected no plugin is attached for that slot and the core's
+// own dummy plugin is used, which needs no devices and does nothing.
+const QString NullPlugin = "null";
+
+// Name of the input plugin that plays the controller input of the script
+// in Input/script, so games can run headless. It is built with the
+// frontend and installed next to it rather than in the plugin directory.
+const QString ScriptPlugin = "script";
+const QString ScriptPluginLibrary = "mupen64plus-input-script";
+
+// The built-in plugins have no settings of their own.
+bool isBuiltinPlugin(const QString &name);
+
+
+// Plugin and config overrides for a single game. Empty values mean that
+// the global setting is used.
+struct GameSettings {
+    QString video;
+    QString audio;
+    QString input;
+    QString rsp;
+    QString config;
+
+    bool isEmpty() const;
+};
+
 
 QStringList getAvailableVideoPlugins();
 
@@ -45,6 +75,8 @@ QStringList getAvailableInputPlugins();
 QStringList getAvailableRspPlugins();
 
 
+// The game argument is the MD5 of the ROM. If that game has an override
+// for the plugin it is returned, otherwise the global plugin.
 QString getCurrentVideoPlugin(QString game = "");
 
 QString getCurrentAudioPlugin(QString game = "");
@@ -54,4 +86,21 @@ QString getCurrentInputPlugin(QString game = "");
 QString getCurrentRspPlugin(QString game = "");
 
 
+// Per-game settings are stored in the game_settings table of the
+// database, keyed by ROM MD5 so they follow the game when the file is
+// renamed or moved. loadGameSettings reads the whole table into memory
+// and must be called from the main thread before the others are used;
+// lookups after that never touch the database.
+void loadGameSettings();
+
+GameSettings getGameSettings(const QString &md5);
+
+void setGameSettings(const QString &md5, const GameSettings &settings);
+
+// Moves overrides from the old INI groups, which were named after the
+// ROM file name, to the database for the given ROMs and the other
+// copies in their alternateLocations.
+void migrateGameSettings(const QList<Rom> &roms);
+
+
 #endif // SETTINGS_H
@@ -73,7 +73,7 @@ GridView::GridView(QWidget *parent) : QScrollArea(parent)
 }
 
 
-void GridView::addToGridView(Rom *currentRom, int count, bool ddEnabled)
+void GridView::addToGridView(const Rom *currentRom, int count, bool ddEnabled)
 {
     if (ddEnabled) // Add place for "No Cart" entry
         count++;
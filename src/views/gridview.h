@@ -44,7 +44,7 @@ class GridView : public QScrollArea
 
 public:
     explicit GridView(QWidget *parent = 0);
-    void addToGridView(Rom *currentRom, int count, bool ddEnabled);
+    void addToGridView(const Rom *currentRom, int count, bool ddEnabled);
     int getCurrentRom();
     QString getCurrentRomInfo(QString infoName);
     QWidget *getCurrentRomWidget();
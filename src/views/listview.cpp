@@ -70,7 +70,7 @@ ListView::ListView(QWidget *parent) : QScrollArea(parent)
 }
 
 
-void ListView::addToListView(Rom *currentRom, int count, bool ddEnabled)
+void ListView::addToListView(const Rom *currentRom, int count, bool ddEnabled)
 {
     if (ddEnabled) // Add place for "No Cart" entry
         count++;
@@ -44,7 +44,7 @@ class ListView : public QScrollArea
 
 public:
     explicit ListView(QWidget *parent = 0);
-    void addToListView(Rom *currentRom, int count, bool ddEnabled);
+    void addToListView(const Rom *currentRom, int count, bool ddEnabled);
     int getCurrentRom();
     QString getCurrentRomInfo(QString infoName);
     QWidget *getCurrentRomWidget();
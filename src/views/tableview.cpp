@@ -83,7 +83,7 @@ void TableView::addNoCartRow()
 }
 
 
-void TableView::addToTableView(Rom *currentRom)
+void TableView::addToTableView(const Rom *currentRom)
 {
     QStringList visible = SETTINGS.value("Table/columns", "Filename|Size").toString().split("|");
 
@@ -45,7 +45,7 @@ class TableView : public QTreeWidget
 public:
     explicit TableView(QWidget *parent = 0);
     void addNoCartRow();
-    void addToTableView(Rom *currentRom);
+    void addToTableView(const Rom *currentRom);
     QString getCurrentRomInfo(QString infoName);
     bool hasSelectedRom();
     void resetView(bool imageUpdated);